@@ -56,6 +56,10 @@ ifdef FW_PAYLOAD_ALIGN
 firmware-genflags-$(FW_PAYLOAD) += -DFW_PAYLOAD_ALIGN=$(FW_PAYLOAD_ALIGN)
 endif
 
+ifeq ($(FW_PAYLOAD_BENCH),y)
+firmware-genflags-$(FW_PAYLOAD) += -DFW_PAYLOAD_BENCH
+endif
+
 ifdef FW_PAYLOAD_FDT_OFFSET
 firmware-genflags-$(FW_PAYLOAD) += -DFW_PAYLOAD_FDT_OFFSET=$(FW_PAYLOAD_FDT_OFFSET)
 endif
@@ -11,6 +11,7 @@ firmware-bins-$(FW_PAYLOAD) += payloads/test.bin
 
 test-y += test_head.o
 test-y += test_main.o
+test-$(FW_PAYLOAD_BENCH) += test_bench.o
 
 %/test.o: $(foreach obj,$(test-y),%/$(obj))
 	$(call merge_objs,$@,$^)
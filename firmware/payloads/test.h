@@ -0,0 +1,42 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2019 Western Digital Corporation or its affiliates.
+ *
+ * Authors:
+ *   Anup Patel <anup.patel@wdc.com>
+ */
+
+#ifndef __TEST_PAYLOAD_H__
+#define __TEST_PAYLOAD_H__
+
+#include <sbi/sbi_ecall_interface.h>
+#include <sbi/sbi_string.h>
+
+struct sbiret {
+	unsigned long error;
+	unsigned long value;
+};
+
+struct sbiret sbi_ecall(int ext, int fid, unsigned long arg0,
+			unsigned long arg1, unsigned long arg2,
+			unsigned long arg3, unsigned long arg4,
+			unsigned long arg5);
+
+static inline void sbi_ecall_console_puts(const char *str)
+{
+	sbi_ecall(SBI_EXT_DBCN, SBI_EXT_DBCN_CONSOLE_WRITE,
+		  sbi_strlen(str), (unsigned long)str, 0, 0, 0, 0);
+}
+
+#define wfi()                                             \
+	do {                                              \
+		__asm__ __volatile__("wfi" ::: "memory"); \
+	} while (0)
+
+#ifdef FW_PAYLOAD_BENCH
+void test_bench(unsigned long hartid);
+void test_secondary(unsigned long hartid, unsigned long stack_top);
+#endif
+
+#endif
@@ -0,0 +1,996 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 Sophgo Technology Inc.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/sbi_batch.h>
+#include <sbi/sbi_latency.h>
+#include <sbi/sbi_tlb.h>
+#include "test.h"
+
+#define BENCH_ROUNDS		1024
+
+static inline unsigned long rdtime(void)
+{
+	unsigned long t;
+
+	__asm__ __volatile__("rdtime %0" : "=r"(t));
+	return t;
+}
+
+static void print_ulong(unsigned long val)
+{
+	char buf[24];
+	int pos = sizeof(buf) - 1;
+
+	buf[pos] = '\0';
+	do {
+		buf[--pos] = '0' + (val % 10);
+		val /= 10;
+	} while (val && pos);
+
+	sbi_ecall_console_puts(&buf[pos]);
+}
+
+static inline unsigned long rdcycle(void)
+{
+	unsigned long c;
+
+	__asm__ __volatile__("rdcycle %0" : "=r"(c));
+	return c;
+}
+
+/* Extension ID which no extension is registered for */
+#define BENCH_EXT_NONE		0x4E4F4E45
+
+struct bench_ecall {
+	const char *name;
+	unsigned long ext;
+	unsigned long fid;
+	unsigned long arg0;
+	unsigned long arg1;
+};
+
+/*
+ * Average ecall round trip in cycles for one cheap call of each
+ * extension. Calls that change the HART, system or event state (SRST,
+ * SUSP, HSM start/stop/suspend and SSE) are left out, and the others
+ * use arguments that make them no-ops: no target HARTs, a timer
+ * deadline that never expires and an empty console write.
+ */
+static void bench_ecalls(unsigned long hartid)
+{
+	const struct bench_ecall calls[] = {
+		{ "legacy set_timer", SBI_EXT_0_1_SET_TIMER, 0, -1UL, 0 },
+		{ "base get_spec_version", SBI_EXT_BASE,
+		  SBI_EXT_BASE_GET_SPEC_VERSION, 0, 0 },
+		{ "time set_timer", SBI_EXT_TIME, SBI_EXT_TIME_SET_TIMER,
+		  -1UL, 0 },
+		{ "ipi send_ipi", SBI_EXT_IPI, SBI_EXT_IPI_SEND_IPI, 0, 0 },
+		{ "rfence remote_fence_i", SBI_EXT_RFENCE,
+		  SBI_EXT_RFENCE_REMOTE_FENCE_I, 0, 0 },
+		{ "hsm hart_get_status", SBI_EXT_HSM,
+		  SBI_EXT_HSM_HART_GET_STATUS, hartid, 0 },
+		{ "pmu num_counters", SBI_EXT_PMU, SBI_EXT_PMU_NUM_COUNTERS,
+		  0, 0 },
+		{ "dbcn console_write", SBI_EXT_DBCN,
+		  SBI_EXT_DBCN_CONSOLE_WRITE, 0, (unsigned long)calls },
+		{ "cppc probe", SBI_EXT_CPPC, SBI_EXT_CPPC_PROBE,
+		  SBI_CPPC_HIGHEST_PERF, 0 },
+		{ "dbtr num_triggers", SBI_EXT_DBTR, SBI_EXT_DBTR_NUM_TRIGGERS,
+		  0, 0 },
+		{ "fwft get", SBI_EXT_FWFT, SBI_EXT_FWFT_GET,
+		  SBI_FWFT_MISALIGNED_EXC_DELEG, 0 },
+		{ "mpxy get_shmem_size", SBI_EXT_MPXY,
+		  SBI_EXT_MPXY_GET_SHMEM_SIZE, 0, 0 },
+		{ "unknown extension", BENCH_EXT_NONE, 0, 0, 0 },
+	};
+	unsigned long i, j, start, cycles;
+	struct sbiret ret;
+
+	for (i = 0; i < array_size(calls); i++) {
+		if (calls[i].ext != BENCH_EXT_NONE) {
+			ret = sbi_ecall(SBI_EXT_BASE, SBI_EXT_BASE_PROBE_EXT,
+					calls[i].ext, 0, 0, 0, 0, 0);
+			if (ret.error || !ret.value)
+				continue;
+		}
+
+		start = rdcycle();
+		for (j = 0; j < BENCH_ROUNDS; j++)
+			sbi_ecall(calls[i].ext, calls[i].fid, calls[i].arg0,
+				  calls[i].arg1, 0, 0, 0, 0);
+		cycles = rdcycle() - start;
+
+		sbi_ecall_console_puts("ecall ");
+		sbi_ecall_console_puts(calls[i].name);
+		sbi_ecall_console_puts(": ");
+		print_ulong(cycles / BENCH_ROUNDS);
+		sbi_ecall_console_puts(" cycles\n");
+	}
+}
+
+#define BATCH_MAX_ENTRIES	64
+
+static struct sbi_batch_entry batch_ring[BATCH_MAX_ENTRIES];
+
+/*
+ * Time batches of count get_spec_version calls, issued either one
+ * ecall per call or through a single batch ecall.
+ */
+static void bench_batch(unsigned long count)
+{
+	unsigned long i, j, start, single, batched;
+	struct sbiret ret;
+
+	start = rdtime();
+	for (i = 0; i < BENCH_ROUNDS / count; i++)
+		for (j = 0; j < count; j++)
+			sbi_ecall(SBI_EXT_BASE, SBI_EXT_BASE_GET_SPEC_VERSION,
+				  0, 0, 0, 0, 0, 0);
+	single = rdtime() - start;
+
+	for (j = 0; j < count; j++) {
+		batch_ring[j].extid = SBI_EXT_BASE;
+		batch_ring[j].funcid = SBI_EXT_BASE_GET_SPEC_VERSION;
+	}
+
+	start = rdtime();
+	for (i = 0; i < BENCH_ROUNDS / count; i++) {
+		ret = sbi_ecall(SBI_EXT_OPENSBI, SBI_EXT_OPENSBI_BATCH_EXEC,
+				0, count, 0, 0, 0, 0);
+		if (ret.error)
+			return;
+	}
+	batched = rdtime() - start;
+
+	sbi_ecall_console_puts("batch of ");
+	print_ulong(count);
+	sbi_ecall_console_puts(": single ");
+	print_ulong((single * 100) / BENCH_ROUNDS);
+	sbi_ecall_console_puts(", batched ");
+	print_ulong((batched * 100) / BENCH_ROUNDS);
+	sbi_ecall_console_puts(" ticks/100 calls\n");
+}
+
+static void bench_batches(void)
+{
+	struct sbiret ret;
+
+	ret = sbi_ecall(SBI_EXT_OPENSBI, SBI_EXT_OPENSBI_BATCH_SET_SHMEM,
+			(unsigned long)batch_ring, 0, BATCH_MAX_ENTRIES,
+			0, 0, 0);
+	if (ret.error) {
+		sbi_ecall_console_puts("batched calls not available\n");
+		return;
+	}
+
+	bench_batch(1);
+	bench_batch(4);
+	bench_batch(16);
+	bench_batch(64);
+
+	sbi_ecall(SBI_EXT_OPENSBI, SBI_EXT_OPENSBI_BATCH_SET_SHMEM,
+		  -1UL, -1UL, 0, 0, 0, 0);
+}
+
+#define TICK_BENCH_TICKS	256
+#define TICK_BENCH_PERIOD	100
+#define TICK_BENCH_TIMEOUT	(TICK_BENCH_PERIOD * 10000)
+
+static struct sbi_latency_stats latency_stats;
+
+static unsigned long hist_count(const struct sbi_latency_hist *hist)
+{
+	unsigned long i, count = 0;
+
+	for (i = 0; i < SBI_LATENCY_BUCKETS; i++)
+		count += hist->count[i];
+	return count;
+}
+
+/* Number of traps taken by M-mode on this HART so far (or 0) */
+static unsigned long mmode_traps(unsigned long hartid)
+{
+	unsigned long i, traps = 0;
+	struct sbiret ret;
+
+	ret = sbi_ecall(SBI_EXT_OPENSBI, SBI_EXT_OPENSBI_LATENCY_SNAPSHOT,
+			hartid, (unsigned long)&latency_stats, 0,
+			sizeof(latency_stats), 0, 0);
+	if (ret.error)
+		return 0;
+
+	for (i = 0; i < SBI_LATENCY_EXC_CAUSES; i++)
+		traps += hist_count(&latency_stats.exc[i]);
+	for (i = 0; i < SBI_LATENCY_IRQ_CAUSES; i++)
+		traps += hist_count(&latency_stats.irq[i]);
+	return traps + hist_count(&latency_stats.trap_other);
+}
+
+/*
+ * Run a periodic supervisor timer and count the M-mode traps it costs.
+ * Interrupts are not enabled, the pending STIP bit is polled instead.
+ * With Sstc only the set_timer ecall traps, otherwise the M-mode timer
+ * interrupt forwarding the tick traps as well. The trap count needs the
+ * OpenSBI latency histograms and the rate is per million timer ticks
+ * since the timebase frequency is platform specific.
+ *
+ * A tick that does not show up within TICK_BENCH_TIMEOUT timer ticks
+ * ends the benchmark, so platforms without a working timer do not hang.
+ */
+static void bench_ticks(unsigned long hartid)
+{
+	unsigned long i, start, deadline, elapsed, traps;
+
+	traps = mmode_traps(hartid);
+	start = rdtime();
+	for (i = 0; i < TICK_BENCH_TICKS; i++) {
+		sbi_ecall(SBI_EXT_TIME, SBI_EXT_TIME_SET_TIMER,
+			  rdtime() + TICK_BENCH_PERIOD, 0, 0, 0, 0, 0);
+		deadline = rdtime() + TICK_BENCH_TIMEOUT;
+		while (!(csr_read(CSR_SIP) & SIP_STIP) &&
+		       (long)(rdtime() - deadline) < 0)
+			;
+		if (!(csr_read(CSR_SIP) & SIP_STIP))
+			break;
+	}
+	elapsed = rdtime() - start;
+	sbi_ecall(SBI_EXT_TIME, SBI_EXT_TIME_SET_TIMER, -1UL, 0, 0, 0, 0, 0);
+
+	if (i < TICK_BENCH_TICKS) {
+		sbi_ecall_console_puts("timer ticks: timer interrupt not "
+				       "delivered\n");
+		return;
+	}
+
+	sbi_ecall_console_puts("timer ticks: ");
+	print_ulong((elapsed * 100) / TICK_BENCH_TICKS);
+	sbi_ecall_console_puts(" ticks/100 periods");
+	if (traps) {
+		/* Leave out the trap of the second statistics snapshot */
+		traps = mmode_traps(hartid) - traps - 1;
+		sbi_ecall_console_puts(", M-mode traps: ");
+		print_ulong((traps * 100) / TICK_BENCH_TICKS);
+		sbi_ecall_console_puts("/100 periods, ");
+		print_ulong((traps * 1000000) / elapsed);
+		sbi_ecall_console_puts("/1M timer ticks");
+	}
+	sbi_ecall_console_puts("\n");
+}
+
+#define TLB_BENCH_MAX_PAGES	512
+#define TLB_BENCH_ROUNDS	16
+#define TLB_BENCH_PAGE_SIZE	4096UL
+
+/*
+ * Check for Svinval by executing SFENCE.W.INVAL with stvec pointing
+ * right after it, so an illegal instruction trap just skips it.
+ */
+static bool tlb_has_svinval(void)
+{
+	unsigned long found, stvec;
+
+	__asm__ __volatile__("lla	%1, 1f\n"
+			     "csrrw	%1, stvec, %1\n"
+			     "li	%0, 0\n"
+			     ".word	0x18000073\n"
+			     "li	%0, 1\n"
+			     ".align	2\n"
+			     "1:\n"
+			     "csrw	stvec, %1\n"
+			     : "=&r"(found), "=&r"(stvec) : : "memory");
+
+	return found;
+}
+
+static void tlb_flush_sfence(unsigned long pages)
+{
+	unsigned long i;
+
+	for (i = 0; i < pages; i++)
+		__asm__ __volatile__("sfence.vma %0"
+				     :
+				     : "r"(i * TLB_BENCH_PAGE_SIZE)
+				     : "memory");
+}
+
+/* Svinval instructions, encoded for assemblers without Svinval */
+static void tlb_flush_svinval(unsigned long pages)
+{
+	register unsigned long va asm("a0");
+	unsigned long i;
+
+	/* SFENCE.W.INVAL */
+	__asm__ __volatile__(".word 0x18000073" : : : "memory");
+	for (i = 0; i < pages; i++) {
+		/* SINVAL.VMA a0 */
+		va = i * TLB_BENCH_PAGE_SIZE;
+		__asm__ __volatile__(".word 0x16050073"
+				     : : "r"(va) : "memory");
+	}
+	/* SFENCE.INVAL.IR */
+	__asm__ __volatile__(".word 0x18100073" : : : "memory");
+}
+
+/*
+ * Time flushing ranges of 1 to TLB_BENCH_MAX_PAGES pages, locally one
+ * SFENCE.VMA per page and with a Svinval run, and through the SBI remote
+ * SFENCE.VMA of this HART which uses whatever OpenSBI picked for the
+ * range. Reported numbers are cycles per range.
+ */
+static void bench_tlb_flush(unsigned long hartid)
+{
+	bool svinval = tlb_has_svinval();
+	unsigned long pages, i, start, sfence, inval, sbi;
+
+	for (pages = 1; pages <= TLB_BENCH_MAX_PAGES; pages *= 2) {
+		start = rdcycle();
+		for (i = 0; i < TLB_BENCH_ROUNDS; i++)
+			tlb_flush_sfence(pages);
+		sfence = rdcycle() - start;
+
+		inval = 0;
+		if (svinval) {
+			start = rdcycle();
+			for (i = 0; i < TLB_BENCH_ROUNDS; i++)
+				tlb_flush_svinval(pages);
+			inval = rdcycle() - start;
+		}
+
+		start = rdcycle();
+		for (i = 0; i < TLB_BENCH_ROUNDS; i++)
+			sbi_ecall(SBI_EXT_RFENCE,
+				  SBI_EXT_RFENCE_REMOTE_SFENCE_VMA, 1, hartid,
+				  0, pages * TLB_BENCH_PAGE_SIZE, 0, 0);
+		sbi = rdcycle() - start;
+
+		sbi_ecall_console_puts("tlb flush ");
+		print_ulong(pages);
+		sbi_ecall_console_puts(" pages: sfence.vma ");
+		print_ulong(sfence / TLB_BENCH_ROUNDS);
+		if (svinval) {
+			sbi_ecall_console_puts(", svinval ");
+			print_ulong(inval / TLB_BENCH_ROUNDS);
+		}
+		sbi_ecall_console_puts(", sbi rfence ");
+		print_ulong(sbi / TLB_BENCH_ROUNDS);
+		sbi_ecall_console_puts(" cycles\n");
+	}
+}
+
+#define BENCH_MAX_HARTS		128
+#define BENCH_MAX_HARTID	1024
+#define BENCH_STACK_SIZE	2048
+#define BENCH_START_TIMEOUT	100000000UL
+
+extern char _start_secondary[];
+
+/* Secondary HARTs started for the multi-HART benchmarks */
+static unsigned long bench_hartids[BENCH_MAX_HARTS];
+static unsigned long bench_nharts;
+static unsigned long bench_stacks[BENCH_MAX_HARTS]
+			[BENCH_STACK_SIZE / sizeof(unsigned long)] __aligned(16);
+
+/* Command run by the first nharts secondary HARTs */
+static struct {
+	void (*fn)(unsigned long idx);
+	unsigned long nharts;
+} bench_cmd;
+static unsigned long bench_gen;
+static unsigned long bench_done;
+static unsigned long bench_online;
+
+/*
+ * The payload does not link any OpenSBI library code, so it uses the
+ * compiler atomics. All of them are fully ordered.
+ */
+#define bench_read(__p)		__atomic_load_n((__p), __ATOMIC_SEQ_CST)
+#define bench_write(__p, __v)	__atomic_store_n((__p), (__v), __ATOMIC_SEQ_CST)
+#define bench_inc(__p)		__atomic_fetch_add((__p), 1, __ATOMIC_SEQ_CST)
+
+/*
+ * Command loop of the secondary HARTs. The index of the HART among the
+ * secondary HARTs is given by the stack it was started with.
+ */
+void test_secondary(unsigned long hartid, unsigned long stack_top)
+{
+	unsigned long idx, gen;
+
+	idx = (stack_top - (unsigned long)bench_stacks) / BENCH_STACK_SIZE - 1;
+	gen = bench_read(&bench_gen);
+	bench_inc(&bench_online);
+
+	while (1) {
+		while (bench_read(&bench_gen) == gen)
+			cpu_relax();
+		gen++;
+
+		if (idx < bench_cmd.nharts)
+			bench_cmd.fn(idx);
+		bench_inc(&bench_done);
+	}
+}
+
+/* Start fn on the first nharts secondary HARTs without waiting */
+static void bench_run(void (*fn)(unsigned long idx), unsigned long nharts)
+{
+	bench_cmd.fn = fn;
+	bench_cmd.nharts = nharts;
+	bench_write(&bench_done, 0);
+	bench_inc(&bench_gen);
+}
+
+/* Wait for all secondary HARTs to finish the current command */
+static void bench_wait(void)
+{
+	while (bench_read(&bench_done) != bench_nharts)
+		cpu_relax();
+}
+
+/*
+ * Start every stopped HART, up to BENCH_MAX_HARTS of them, into the
+ * secondary command loop. Multi-HART benchmarks are skipped when a
+ * started HART does not show up within BENCH_START_TIMEOUT timer ticks.
+ */
+static void bench_start_harts(unsigned long hartid)
+{
+	unsigned long i, n = 0, deadline;
+	struct sbiret ret;
+
+	for (i = 0; i < BENCH_MAX_HARTID && n < BENCH_MAX_HARTS; i++) {
+		if (i == hartid)
+			continue;
+
+		ret = sbi_ecall(SBI_EXT_HSM, SBI_EXT_HSM_HART_GET_STATUS,
+				i, 0, 0, 0, 0, 0);
+		if (ret.error || ret.value != SBI_HSM_STATE_STOPPED)
+			continue;
+
+		ret = sbi_ecall(SBI_EXT_HSM, SBI_EXT_HSM_HART_START, i,
+				(unsigned long)_start_secondary,
+				(unsigned long)&bench_stacks[n + 1], 0, 0, 0);
+		if (!ret.error)
+			bench_hartids[n++] = i;
+	}
+
+	deadline = rdtime() + BENCH_START_TIMEOUT;
+	while (bench_read(&bench_online) != n &&
+	       (long)(rdtime() - deadline) < 0)
+		cpu_relax();
+	if (bench_read(&bench_online) != n) {
+		sbi_ecall_console_puts("secondary harts did not start\n");
+		return;
+	}
+
+	bench_nharts = n;
+	sbi_ecall_console_puts("started ");
+	print_ulong(n);
+	sbi_ecall_console_puts(" secondary harts\n");
+}
+
+/* Next producer count to run with, doubling up to max */
+static unsigned long bench_next_count(unsigned long count, unsigned long max)
+{
+	if (count < max && count * 2 > max)
+		return max;
+	return count * 2;
+}
+
+#define FIFO_STRESS_ENTRIES	64
+#define FIFO_STRESS_OPS		4096
+#define FIFO_STRESS_TIMEOUT	1000000000UL
+
+struct fifo_stress_entry {
+	unsigned long producer;
+	unsigned long seq;
+	unsigned long data[6];
+};
+
+/* Word by word copy, so the compiler never needs a memcpy() */
+static void fifo_stress_copy(struct fifo_stress_entry *dst,
+			     const struct fifo_stress_entry *src)
+{
+	volatile unsigned long *d = (volatile unsigned long *)dst;
+	const unsigned long *p = (const unsigned long *)src;
+	unsigned long i;
+
+	for (i = 0; i < sizeof(*dst) / sizeof(unsigned long); i++)
+		d[i] = p[i];
+}
+
+/*
+ * Spinlocked ring, the scheme of sbi_fifo: a ticket lock serializes all
+ * producers and the consumer.
+ */
+struct stress_lock_ring {
+	unsigned int next;
+	unsigned int owner;
+	unsigned long head;
+	unsigned long tail;
+	struct fifo_stress_entry entries[FIFO_STRESS_ENTRIES];
+};
+
+static void stress_lock(struct stress_lock_ring *r)
+{
+	unsigned int ticket = __atomic_fetch_add(&r->next, 1, __ATOMIC_RELAXED);
+
+	while (__atomic_load_n(&r->owner, __ATOMIC_ACQUIRE) != ticket)
+		cpu_relax();
+}
+
+static void stress_unlock(struct stress_lock_ring *r)
+{
+	__atomic_store_n(&r->owner, r->owner + 1, __ATOMIC_RELEASE);
+}
+
+static int stress_lock_enqueue(struct stress_lock_ring *r,
+			       const struct fifo_stress_entry *entry)
+{
+	int rc = -1;
+
+	stress_lock(r);
+	if (r->tail - r->head < FIFO_STRESS_ENTRIES) {
+		fifo_stress_copy(&r->entries[r->tail++ % FIFO_STRESS_ENTRIES],
+				 entry);
+		rc = 0;
+	}
+	stress_unlock(r);
+
+	return rc;
+}
+
+static int stress_lock_dequeue(struct stress_lock_ring *r,
+			       struct fifo_stress_entry *entry)
+{
+	int rc = -1;
+
+	stress_lock(r);
+	if (r->tail != r->head) {
+		fifo_stress_copy(entry,
+				 &r->entries[r->head++ % FIFO_STRESS_ENTRIES]);
+		rc = 0;
+	}
+	stress_unlock(r);
+
+	return rc;
+}
+
+/*
+ * Lock-free ring, the scheme of sbi_mpsc_fifo: producers reserve a slot
+ * by moving the head with a compare-and-swap and publish it through the
+ * slot sequence number, the single consumer needs no atomics at all.
+ */
+struct stress_mpsc_ring {
+	unsigned long head;
+	unsigned long tail;
+	unsigned long seq[FIFO_STRESS_ENTRIES];
+	struct fifo_stress_entry entries[FIFO_STRESS_ENTRIES];
+};
+
+static int stress_mpsc_enqueue(struct stress_mpsc_ring *r,
+			       const struct fifo_stress_entry *entry)
+{
+	unsigned long pos, seq;
+
+	pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+	while (1) {
+		seq = __atomic_load_n(&r->seq[pos % FIFO_STRESS_ENTRIES],
+				      __ATOMIC_ACQUIRE);
+		if (seq == pos) {
+			if (__atomic_compare_exchange_n(&r->head, &pos, pos + 1,
+							false,
+							__ATOMIC_RELAXED,
+							__ATOMIC_RELAXED))
+				break;
+		} else if ((long)(seq - pos) < 0) {
+			/* Slot still holds an entry from the previous lap */
+			return -1;
+		} else {
+			pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+		}
+	}
+
+	fifo_stress_copy(&r->entries[pos % FIFO_STRESS_ENTRIES], entry);
+	__atomic_store_n(&r->seq[pos % FIFO_STRESS_ENTRIES], pos + 1,
+			 __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+static int stress_mpsc_dequeue(struct stress_mpsc_ring *r,
+			       struct fifo_stress_entry *entry)
+{
+	unsigned long pos = r->tail;
+
+	if (__atomic_load_n(&r->seq[pos % FIFO_STRESS_ENTRIES],
+			    __ATOMIC_ACQUIRE) != pos + 1)
+		return -1;
+
+	fifo_stress_copy(entry, &r->entries[pos % FIFO_STRESS_ENTRIES]);
+	r->tail = pos + 1;
+	__atomic_store_n(&r->seq[pos % FIFO_STRESS_ENTRIES],
+			 pos + FIFO_STRESS_ENTRIES, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+static bool fifo_stress_mpsc;
+static struct stress_lock_ring stress_lock_ring;
+static struct stress_mpsc_ring stress_mpsc_ring;
+static unsigned long stress_next[BENCH_MAX_HARTS];
+
+static void fifo_stress_produce(unsigned long idx)
+{
+	struct fifo_stress_entry entry = { .producer = idx };
+
+	for (entry.seq = 0; entry.seq < FIFO_STRESS_OPS; entry.seq++) {
+		if (fifo_stress_mpsc) {
+			while (stress_mpsc_enqueue(&stress_mpsc_ring, &entry))
+				cpu_relax();
+		} else {
+			while (stress_lock_enqueue(&stress_lock_ring, &entry))
+				cpu_relax();
+		}
+	}
+}
+
+/*
+ * Drain the entries of all producers on this HART, checking that the
+ * entries of each producer come out once and in order. Returns the
+ * consumer cycles per entry or 0 on failure.
+ */
+static unsigned long fifo_stress(bool mpsc, unsigned long producers)
+{
+	unsigned long i, n, start, deadline;
+	unsigned long total = producers * FIFO_STRESS_OPS;
+	struct fifo_stress_entry entry;
+	int rc;
+
+	fifo_stress_mpsc = mpsc;
+	stress_lock_ring.next = stress_lock_ring.owner = 0;
+	stress_lock_ring.head = stress_lock_ring.tail = 0;
+	stress_mpsc_ring.head = stress_mpsc_ring.tail = 0;
+	for (i = 0; i < FIFO_STRESS_ENTRIES; i++)
+		stress_mpsc_ring.seq[i] = i;
+	for (i = 0; i < producers; i++)
+		stress_next[i] = 0;
+
+	start = rdcycle();
+	deadline = rdtime() + FIFO_STRESS_TIMEOUT;
+	bench_run(fifo_stress_produce, producers);
+
+	for (n = 0; n < total; ) {
+		if (mpsc)
+			rc = stress_mpsc_dequeue(&stress_mpsc_ring, &entry);
+		else
+			rc = stress_lock_dequeue(&stress_lock_ring, &entry);
+		if (rc) {
+			if ((long)(rdtime() - deadline) >= 0)
+				return 0;
+			continue;
+		}
+
+		if (entry.producer >= producers ||
+		    entry.seq != stress_next[entry.producer]++)
+			return 0;
+		n++;
+	}
+	start = rdcycle() - start;
+
+	bench_wait();
+	return start / total;
+}
+
+#define RFENCE_STRESS_OPS	256
+
+static unsigned long rfence_stress_target;
+static unsigned long rfence_stress_cycles[BENCH_MAX_HARTS];
+
+static void rfence_stress_send(unsigned long idx)
+{
+	unsigned long i, start = rdcycle();
+
+	for (i = 0; i < RFENCE_STRESS_OPS; i++)
+		sbi_ecall(SBI_EXT_RFENCE, SBI_EXT_RFENCE_REMOTE_SFENCE_VMA,
+			  1, rfence_stress_target, i * TLB_BENCH_PAGE_SIZE,
+			  TLB_BENCH_PAGE_SIZE, 0, 0);
+	rfence_stress_cycles[idx] = rdcycle() - start;
+}
+
+static struct sbi_tlb_coalesce_stats tlb_stats;
+
+/* Per-target fence requests queued and merged by the given HARTs */
+static void tlb_fifo_requests(unsigned long nharts, unsigned long *queued,
+			      unsigned long *merged)
+{
+	unsigned long i;
+	struct sbiret ret;
+
+	*queued = *merged = 0;
+	for (i = 0; i < nharts; i++) {
+		ret = sbi_ecall(SBI_EXT_OPENSBI, SBI_EXT_OPENSBI_TLB_STATS,
+				bench_hartids[i], (unsigned long)&tlb_stats, 0,
+				sizeof(tlb_stats), 0, 0);
+		if (ret.error)
+			continue;
+		*queued += tlb_stats.queued[SBI_TLB_SFENCE_VMA];
+		*merged += tlb_stats.merged[SBI_TLB_SFENCE_VMA];
+	}
+}
+
+/*
+ * Concurrent producers against a single consumer, first on payload
+ * rings using the schemes of sbi_fifo and sbi_mpsc_fifo, then through
+ * the firmware with all secondary HARTs sending remote SFENCE.VMA
+ * requests to this HART. The firmware runs sbi_mpsc_fifo on this path,
+ * the ring runs show what the sbi_fifo lock costs under the same
+ * contention.
+ */
+static void bench_fifo_stress(unsigned long hartid)
+{
+	unsigned long producers, fifo, mpsc, i, cycles;
+	unsigned long queued, merged, queued_end, merged_end;
+
+	for (producers = 1; producers <= bench_nharts;
+	     producers = bench_next_count(producers, bench_nharts)) {
+		fifo = fifo_stress(false, producers);
+		mpsc = fifo ? fifo_stress(true, producers) : 0;
+		if (!mpsc) {
+			sbi_ecall_console_puts("fifo stress: entries lost or "
+					       "reordered\n");
+			bench_nharts = 0;
+			return;
+		}
+
+		sbi_ecall_console_puts("fifo stress ");
+		print_ulong(producers);
+		sbi_ecall_console_puts(" producers: locked ");
+		print_ulong(fifo);
+		sbi_ecall_console_puts(", lock-free ");
+		print_ulong(mpsc);
+		sbi_ecall_console_puts(" cycles/entry\n");
+	}
+
+	rfence_stress_target = hartid;
+	for (producers = 1; producers <= bench_nharts;
+	     producers = bench_next_count(producers, bench_nharts)) {
+		tlb_fifo_requests(producers, &queued, &merged);
+		bench_run(rfence_stress_send, producers);
+		bench_wait();
+		tlb_fifo_requests(producers, &queued_end, &merged_end);
+
+		cycles = 0;
+		for (i = 0; i < producers; i++)
+			cycles += rfence_stress_cycles[i];
+
+		sbi_ecall_console_puts("rfence stress ");
+		print_ulong(producers);
+		sbi_ecall_console_puts(" senders: ");
+		print_ulong(cycles / (producers * RFENCE_STRESS_OPS));
+		sbi_ecall_console_puts(" cycles/fence, queued ");
+		print_ulong(queued_end - queued);
+		sbi_ecall_console_puts(", merged ");
+		print_ulong(merged_end - merged);
+		sbi_ecall_console_puts("\n");
+	}
+}
+
+#define BCAST_BENCH_ROUNDS	16
+#define BCAST_IPI_TIMEOUT	10000000UL
+
+static struct sbi_latency_stats bcast_latency;
+
+/* M-mode software interrupts taken by a HART so far or -1UL */
+static unsigned long bcast_ipis(unsigned long hartid)
+{
+	struct sbiret ret;
+
+	ret = sbi_ecall(SBI_EXT_OPENSBI, SBI_EXT_OPENSBI_LATENCY_SNAPSHOT,
+			hartid, (unsigned long)&bcast_latency, 0,
+			sizeof(bcast_latency), 0, 0);
+	if (ret.error)
+		return -1UL;
+
+	return hist_count(&bcast_latency.irq[IRQ_M_SOFT]);
+}
+
+/*
+ * Check that every target took an IPI since ipis[] was sampled. The
+ * interrupt of the last request is recorded when the target leaves
+ * M-mode, which may be shortly after the sender saw it complete.
+ */
+static bool bcast_targets_interrupted(unsigned long ntargets,
+				      const unsigned long *ipis)
+{
+	unsigned long i, deadline = rdtime() + BCAST_IPI_TIMEOUT;
+
+	for (i = 0; i < ntargets; i++) {
+		if (ipis[i] == -1UL)
+			continue;
+		while (bcast_ipis(bench_hartids[i]) == ipis[i])
+			if ((long)(rdtime() - deadline) >= 0)
+				return false;
+	}
+
+	return true;
+}
+
+static unsigned long bcast_ipis_start[BENCH_MAX_HARTS];
+
+/*
+ * Send BCAST_BENCH_ROUNDS remote SFENCE.VMA of one page to the first
+ * ntargets secondary HARTs, or to all HARTs when ntargets is 0, and
+ * check how the firmware delivered them: through the target fifos below
+ * SBI_TLB_BCAST_MIN_TARGETS targets and as one broadcast otherwise. The
+ * secondary HARTs sit in their command loop and take the IPIs from there.
+ */
+static void bench_bcast_targets(unsigned long hartid, unsigned long ntargets)
+{
+	unsigned long i, hmask = 0, hbase = -1UL, start, cycles;
+	unsigned long queued, merged, bcasts, bcast_cycles;
+	bool bcast = !ntargets || ntargets >= SBI_TLB_BCAST_MIN_TARGETS;
+	bool ok;
+
+	if (ntargets)
+		hbase = bench_hartids[0];
+	for (i = 0; i < ntargets; i++)
+		hmask |= 1UL << (bench_hartids[i] - hbase);
+	for (i = 0; i < (ntargets ? ntargets : bench_nharts); i++)
+		bcast_ipis_start[i] = bcast_ipis(bench_hartids[i]);
+
+	sbi_ecall(SBI_EXT_OPENSBI, SBI_EXT_OPENSBI_TLB_STATS, hartid,
+		  (unsigned long)&tlb_stats, 0, sizeof(tlb_stats), 0, 0);
+	queued = tlb_stats.queued[SBI_TLB_SFENCE_VMA];
+	merged = tlb_stats.merged[SBI_TLB_SFENCE_VMA];
+	bcasts = tlb_stats.broadcast[SBI_TLB_SFENCE_VMA];
+	bcast_cycles = tlb_stats.broadcast_cycles[SBI_TLB_SFENCE_VMA];
+
+	start = rdcycle();
+	for (i = 0; i < BCAST_BENCH_ROUNDS; i++)
+		sbi_ecall(SBI_EXT_RFENCE, SBI_EXT_RFENCE_REMOTE_SFENCE_VMA,
+			  hmask, hbase, i * TLB_BENCH_PAGE_SIZE,
+			  TLB_BENCH_PAGE_SIZE, 0, 0);
+	cycles = rdcycle() - start;
+
+	sbi_ecall(SBI_EXT_OPENSBI, SBI_EXT_OPENSBI_TLB_STATS, hartid,
+		  (unsigned long)&tlb_stats, 0, sizeof(tlb_stats), 0, 0);
+	queued = tlb_stats.queued[SBI_TLB_SFENCE_VMA] - queued;
+	merged = tlb_stats.merged[SBI_TLB_SFENCE_VMA] - merged;
+	bcasts = tlb_stats.broadcast[SBI_TLB_SFENCE_VMA] - bcasts;
+	bcast_cycles = tlb_stats.broadcast_cycles[SBI_TLB_SFENCE_VMA] -
+		       bcast_cycles;
+
+	if (bcast)
+		ok = bcasts == BCAST_BENCH_ROUNDS && !queued && !merged;
+	else
+		ok = !bcasts &&
+		     queued + merged == ntargets * BCAST_BENCH_ROUNDS;
+	ok = ok && bcast_targets_interrupted(ntargets ? ntargets :
+					     bench_nharts, bcast_ipis_start);
+
+	sbi_ecall_console_puts("bcast ");
+	if (ntargets)
+		print_ulong(ntargets);
+	else
+		sbi_ecall_console_puts("all");
+	sbi_ecall_console_puts(bcast ? " targets broadcast: " :
+				       " targets fifo: ");
+	print_ulong(cycles / BCAST_BENCH_ROUNDS);
+	sbi_ecall_console_puts(" cycles/fence");
+	if (bcasts) {
+		sbi_ecall_console_puts(", firmware ");
+		print_ulong(bcast_cycles / bcasts);
+		sbi_ecall_console_puts(" cycles/broadcast");
+	}
+	sbi_ecall_console_puts(ok ? "\n" : ", FAILED\n");
+}
+
+/*
+ * Remote fence delivery against the number of target HARTs. Targets
+ * must fit in one hart mask window of the RFENCE extension, the run to
+ * all HARTs covers the rest. The delivery mode is fixed at build time,
+ * so flat and tree fan-out are compared by building the firmware and
+ * this payload with and without CONFIG_SBI_TLB_TREE_FANOUT.
+ */
+static void bench_bcast(unsigned long hartid)
+{
+	unsigned long n, max = 0;
+
+	while (max < bench_nharts &&
+	       bench_hartids[max] - bench_hartids[0] < __riscv_xlen)
+		max++;
+
+#ifdef CONFIG_SBI_TLB_TREE_FANOUT
+	sbi_ecall_console_puts("bcast delivery: tree of degree ");
+	print_ulong(CONFIG_SBI_TLB_TREE_DEGREE);
+	sbi_ecall_console_puts("\n");
+#else
+	sbi_ecall_console_puts("bcast delivery: flat\n");
+#endif
+
+	for (n = 1; n < SBI_TLB_BCAST_MIN_TARGETS && n <= max; n++)
+		bench_bcast_targets(hartid, n);
+	for (n = SBI_TLB_BCAST_MIN_TARGETS; n <= max;
+	     n = bench_next_count(n, max))
+		bench_bcast_targets(hartid, n);
+	bench_bcast_targets(hartid, 0);
+}
+
+#ifdef OPENSBI_CC_SUPPORT_VECTOR
+#define VEC_BENCH_ELEMS		256
+
+static unsigned long vec_buf[VEC_BENCH_ELEMS + 1];
+
+/*
+ * Time misaligned unit-stride vle64.v/vse64.v, which trap to M-mode on
+ * harts without misaligned vector access support. Reported numbers are
+ * timer ticks per element, scaled by 100.
+ */
+static void bench_vector(void)
+{
+	unsigned long i, vl, start, ld_ticks, st_ticks, sstatus;
+	char *buf = (char *)vec_buf + 1;
+
+	__asm__ __volatile__("csrs sstatus, %0" : : "r"(SSTATUS_VS));
+	__asm__ __volatile__("csrr %0, sstatus" : "=r"(sstatus));
+	if (!(sstatus & SSTATUS_VS)) {
+		sbi_ecall_console_puts("vector not available\n");
+		return;
+	}
+
+	__asm__ __volatile__(".option push\n"
+			     ".option arch, +v\n"
+			     "vsetvli %0, %1, e64, m8, ta, ma\n"
+			     ".option pop\n"
+			     : "=r"(vl) : "r"(VEC_BENCH_ELEMS));
+
+	start = rdtime();
+	for (i = 0; i < BENCH_ROUNDS / 64; i++)
+		__asm__ __volatile__(".option push\n"
+				     ".option arch, +v\n"
+				     "vle64.v v8, (%0)\n"
+				     ".option pop\n"
+				     : : "r"(buf) : "memory");
+	ld_ticks = rdtime() - start;
+
+	start = rdtime();
+	for (i = 0; i < BENCH_ROUNDS / 64; i++)
+		__asm__ __volatile__(".option push\n"
+				     ".option arch, +v\n"
+				     "vse64.v v8, (%0)\n"
+				     ".option pop\n"
+				     : : "r"(buf) : "memory");
+	st_ticks = rdtime() - start;
+
+	sbi_ecall_console_puts("misaligned vle64.v: ");
+	print_ulong((ld_ticks * 100) / ((BENCH_ROUNDS / 64) * vl));
+	sbi_ecall_console_puts(", vse64.v: ");
+	print_ulong((st_ticks * 100) / ((BENCH_ROUNDS / 64) * vl));
+	sbi_ecall_console_puts(" ticks/100 elements\n");
+}
+#else
+static void bench_vector(void)
+{
+}
+#endif
+
+void test_bench(unsigned long hartid)
+{
+	sbi_ecall_console_puts("Running test payload benchmarks\n");
+
+	bench_ecalls(hartid);
+	bench_batches();
+	bench_vector();
+	bench_ticks(hartid);
+	bench_tlb_flush(hartid);
+
+	bench_start_harts(hartid);
+	if (bench_nharts)
+		bench_fifo_stress(hartid);
+	if (bench_nharts)
+		bench_bcast(hartid);
+}
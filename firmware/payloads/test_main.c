@@ -7,13 +7,7 @@
  *   Anup Patel <anup.patel@wdc.com>
  */
 
-#include <sbi/sbi_ecall_interface.h>
-#include <sbi/sbi_string.h>
-
-struct sbiret {
-	unsigned long error;
-	unsigned long value;
-};
+#include "test.h"
 
 struct sbiret sbi_ecall(int ext, int fid, unsigned long arg0,
 			unsigned long arg1, unsigned long arg2,
@@ -40,21 +34,14 @@ struct sbiret sbi_ecall(int ext, int fid, unsigned long arg0,
 	return ret;
 }
 
-static inline void sbi_ecall_console_puts(const char *str)
-{
-	sbi_ecall(SBI_EXT_DBCN, SBI_EXT_DBCN_CONSOLE_WRITE,
-		  sbi_strlen(str), (unsigned long)str, 0, 0, 0, 0);
-}
-
-#define wfi()                                             \
-	do {                                              \
-		__asm__ __volatile__("wfi" ::: "memory"); \
-	} while (0)
-
 void test_main(unsigned long a0, unsigned long a1)
 {
 	sbi_ecall_console_puts("\nTest payload running\n");
 
+#ifdef FW_PAYLOAD_BENCH
+	test_bench(a0);
+#endif
+
 	while (1)
 		wfi();
 }
@@ -913,6 +913,18 @@
 #define INSN_MASK_FENCE_TSO		0xffffffff
 #define INSN_MATCH_FENCE_TSO		0x8330000f
 
+#define INSN_MASK_RDTIME		0xfffff07f
+#define INSN_MATCH_RDTIME		0xc0102073
+#define INSN_MATCH_RDTIMEH		0xc8102073
+
+#define INSN_MASK_SFENCE_W_INVAL	0xffffffff
+#define INSN_MATCH_SFENCE_W_INVAL	0x18000073
+
+#define INSN_MASK_WRS_NTO		0xffffffff
+#define INSN_MATCH_WRS_NTO		0x00d00073
+#define INSN_MASK_WRS_STO		0xffffffff
+#define INSN_MATCH_WRS_STO		0x01d00073
+
 #define INSN_MASK_VECTOR_UNIT_STRIDE		0xfdf0707f
 #define INSN_MASK_VECTOR_FAULT_ONLY_FIRST	0xfdf0707f
 #define INSN_MASK_VECTOR_STRIDE			0xfc00707f
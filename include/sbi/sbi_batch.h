@@ -0,0 +1,53 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 Sophgo Technology Inc.
+ */
+
+#ifndef __SBI_BATCH_H__
+#define __SBI_BATCH_H__
+
+#include <sbi/sbi_types.h>
+
+/* clang-format off */
+
+/** Maximum number of entries in a per-HART batch ring */
+#define SBI_BATCH_MAX_ENTRIES		256
+
+/* clang-format on */
+
+/**
+ * Entry of the batch ring shared between supervisor and M-mode
+ *
+ * The supervisor fills extid, funcid and args. M-mode writes back the
+ * error and value which the SBI call would have returned.
+ */
+struct sbi_batch_entry {
+	unsigned long extid;
+	unsigned long funcid;
+	unsigned long args[6];
+	long error;
+	unsigned long value;
+};
+
+struct sbi_scratch;
+struct sbi_ecall_return;
+
+#ifdef CONFIG_SBI_BATCH
+
+int sbi_batch_set_shmem(unsigned long addr_lo, unsigned long addr_hi,
+			unsigned long num_entries);
+
+int sbi_batch_exec(unsigned long first, unsigned long count,
+		   struct sbi_ecall_return *out);
+
+int sbi_batch_init(struct sbi_scratch *scratch, bool cold_boot);
+
+#else
+
+static inline int sbi_batch_init(struct sbi_scratch *scratch,
+				 bool cold_boot) { return 0; }
+
+#endif
+
+#endif
@@ -12,8 +12,6 @@
 
 /* clang-format off */
 
-#include <sbi/sbi_types.h>
-
 /* SBI Extension IDs */
 #define SBI_EXT_0_1_SET_TIMER			0x0
 #define SBI_EXT_0_1_CONSOLE_PUTCHAR		0x1
@@ -126,6 +124,10 @@
 #define SBI_EXT_FWFT_SET		0x0
 #define SBI_EXT_FWFT_GET		0x1
 
+#ifndef __ASSEMBLER__
+
+#include <sbi/sbi_types.h>
+
 enum sbi_fwft_feature_t {
 	SBI_FWFT_MISALIGNED_EXC_DELEG		= 0x0,
 	SBI_FWFT_LANDING_PAD			= 0x1,
@@ -460,6 +462,8 @@ enum sbi_sse_state {
 #define SBI_EXT_MPXY_SEND_MSG_WITHOUT_RESP	0x6
 #define SBI_EXT_MPXY_GET_NOTIFICATION_EVENTS	0x7
 
+#endif
+
 /* SBI base specification related macros */
 #define SBI_SPEC_VERSION_MAJOR_OFFSET		24
 #define SBI_SPEC_VERSION_MAJOR_MASK		0x7f
@@ -471,6 +475,23 @@ enum sbi_sse_state {
 #define SBI_EXT_FIRMWARE_START			0x0A000000
 #define SBI_EXT_FIRMWARE_END			0x0AFFFFFF
 
+/* SBI implementation ID of OpenSBI */
+#define SBI_OPENSBI_IMPID			1
+
+/*
+ * OpenSBI firmware specific extension, the low bits of a firmware
+ * specific extension ID are the SBI implementation ID
+ */
+#define SBI_EXT_OPENSBI				(SBI_EXT_FIRMWARE_START + \
+						 SBI_OPENSBI_IMPID)
+
+/* SBI function IDs for OpenSBI firmware specific extension */
+#define SBI_EXT_OPENSBI_LATENCY_SNAPSHOT	0x0
+#define SBI_EXT_OPENSBI_BATCH_SET_SHMEM		0x1
+#define SBI_EXT_OPENSBI_BATCH_EXEC		0x2
+#define SBI_EXT_OPENSBI_TIMER_STATS		0x3
+#define SBI_EXT_OPENSBI_TLB_STATS		0x4
+
 /* SBI return error codes */
 #define SBI_SUCCESS				0
 #define SBI_ERR_FAILED				-1
@@ -12,6 +12,7 @@
 
 #include <sbi/sbi_types.h>
 
+struct sbi_scratch;
 struct sbi_trap_regs;
 
 int sbi_emulate_csr_read(int csr_num, struct sbi_trap_regs *regs,
@@ -20,4 +21,8 @@ int sbi_emulate_csr_read(int csr_num, struct sbi_trap_regs *regs,
 int sbi_emulate_csr_write(int csr_num, struct sbi_trap_regs *regs,
 			  ulong csr_val);
 
+void sbi_emulate_csr_counters_update(struct sbi_scratch *scratch);
+
+int sbi_emulate_csr_init(struct sbi_scratch *scratch, bool cold_boot);
+
 #endif
@@ -81,6 +81,10 @@ enum sbi_hart_extensions {
 	SBI_HART_EXT_SSCTR,
 	/** HART has Ssstateen extension **/
 	SBI_HART_EXT_SSSTATEEN,
+	/** HART has Svinval extension */
+	SBI_HART_EXT_SVINVAL,
+	/** HART has Zawrs extension */
+	SBI_HART_EXT_ZAWRS,
 
 	/** Maximum index of Hart extension */
 	SBI_HART_EXT_MAX,
@@ -161,6 +165,7 @@ void sbi_hart_get_extensions_str(struct sbi_scratch *scratch,
 				 char *extension_str, int nestr);
 bool sbi_hart_has_csr(struct sbi_scratch *scratch, enum sbi_hart_csrs csr);
 
+void sbi_hart_wait_value(const volatile long *addr, long val);
 void __attribute__((noreturn)) sbi_hart_hang(void);
 
 void __attribute__((noreturn))
@@ -36,4 +36,29 @@ void __sbi_hfence_vvma_va(unsigned long va);
 /** Invalidate all possible Stage2 TLBs */
 void __sbi_hfence_vvma_all(void);
 
+/** Order prior stores before subsequent SINVAL/HINVAL (Svinval) */
+void __sbi_sfence_w_inval(void);
+
+/** Order prior SINVAL/HINVAL before subsequent page table walks (Svinval) */
+void __sbi_sfence_inval_ir(void);
+
+/** Invalidate TLB entries for given ASID and virtual address (Svinval) */
+void __sbi_sinval_vma_asid_va(unsigned long va, unsigned long asid);
+
+/** Invalidate TLB entries for given virtual address (Svinval) */
+void __sbi_sinval_vma_va(unsigned long va);
+
+/** Invalidate Stage2 TLBs for given VMID and guest physical address (Svinval) */
+void __sbi_hinval_gvma_vmid_gpa(unsigned long gpa_divby_4,
+				unsigned long vmid);
+
+/** Invalidate Stage2 TLBs for given guest physical address (Svinval) */
+void __sbi_hinval_gvma_gpa(unsigned long gpa_divby_4);
+
+/** Invalidate unified TLB entries for given ASID and guest VA (Svinval) */
+void __sbi_hinval_vvma_asid_va(unsigned long va, unsigned long asid);
+
+/** Invalidate unified TLB entries for given guest VA (Svinval) */
+void __sbi_hinval_vvma_va(unsigned long va);
+
 #endif
@@ -18,6 +18,8 @@
 
 /* clang-format on */
 
+struct sbi_hartmask;
+
 /** IPI hardware device */
 struct sbi_ipi_device {
 	/** Name of the IPI device */
@@ -26,6 +28,13 @@ struct sbi_ipi_device {
 	/** Send IPI to a target HART index */
 	void (*ipi_send)(u32 hart_index);
 
+	/**
+	 * Send IPI to all HART indices set in the mask (optional)
+	 * Note: The caller issues a single barrier before this callback
+	 * so the device may use a burst of relaxed MMIO writes.
+	 */
+	void (*ipi_send_many)(const struct sbi_hartmask *mask);
+
 	/** Clear IPI for the current hart */
 	void (*ipi_clear)(void);
 };
@@ -73,6 +82,8 @@ struct sbi_ipi_event_ops {
 
 int sbi_ipi_send_many(ulong hmask, ulong hbase, u32 event, void *data);
 
+int sbi_ipi_event_raise(const struct sbi_hartmask *mask, u32 event);
+
 int sbi_ipi_event_create(const struct sbi_ipi_event_ops *ops);
 
 void sbi_ipi_event_destroy(u32 event);
@@ -87,6 +98,8 @@ void sbi_ipi_process(void);
 
 int sbi_ipi_raw_send(u32 hartindex);
 
+int sbi_ipi_raw_send_many(const struct sbi_hartmask *mask);
+
 void sbi_ipi_raw_clear(void);
 
 const struct sbi_ipi_device *sbi_ipi_get_device(void);
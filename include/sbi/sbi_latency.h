@@ -0,0 +1,133 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 Sophgo Technology Inc.
+ */
+
+#ifndef __SBI_LATENCY_H__
+#define __SBI_LATENCY_H__
+
+#include <sbi/riscv_asm.h>
+#include <sbi/sbi_types.h>
+
+/* clang-format off */
+
+/**
+ * Number of histogram buckets. Bucket 0 counts latencies below 64 cycles,
+ * bucket i counts latencies in [4^i * 16, 4^i * 64) cycles and the last
+ * bucket counts everything above.
+ */
+#define SBI_LATENCY_BUCKETS		8
+/** Number of (extid, funcid) pairs tracked per HART */
+#define SBI_LATENCY_ECALL_SLOTS		16
+/** Number of exception causes tracked per HART */
+#define SBI_LATENCY_EXC_CAUSES		24
+/** Number of interrupt causes tracked per HART */
+#define SBI_LATENCY_IRQ_CAUSES		16
+/** Illegal instructions are tracked by major opcode (insn[6:2]) */
+#define SBI_LATENCY_ILLEGAL_OPS		32
+
+/* clang-format on */
+
+/** Latency histogram */
+struct sbi_latency_hist {
+	u32 count[SBI_LATENCY_BUCKETS];
+	/** Total cycles of all the recorded latencies */
+	u64 cycles;
+	/** Largest recorded latency in cycles */
+	u64 max;
+};
+
+/** Latency histogram of one (extid, funcid) pair */
+struct sbi_latency_ecall_hist {
+	/** SBI extension ID (-1U if the slot is unused) */
+	u32 extid;
+	/** SBI function ID */
+	u32 funcid;
+	struct sbi_latency_hist hist;
+};
+
+/**
+ * Per-HART latency histograms
+ *
+ * This is also the layout of the snapshot copied into supervisor memory
+ * by the SBI_EXT_OPENSBI_LATENCY_SNAPSHOT function, so it is ABI: the
+ * size and the order of the fields (including the sizes above and of
+ * struct sbi_latency_hist) must not change once released. A different
+ * layout needs a new function ID.
+ */
+struct sbi_latency_stats {
+	/** Histograms of the first (extid, funcid) pairs seen */
+	struct sbi_latency_ecall_hist ecall[SBI_LATENCY_ECALL_SLOTS];
+	/** Histogram of ecalls not fitting in the ecall slots */
+	struct sbi_latency_hist ecall_other;
+	/** Histograms of traps indexed by exception cause */
+	struct sbi_latency_hist exc[SBI_LATENCY_EXC_CAUSES];
+	/** Histograms of traps indexed by interrupt cause */
+	struct sbi_latency_hist irq[SBI_LATENCY_IRQ_CAUSES];
+	/** Histogram of traps with any other cause */
+	struct sbi_latency_hist trap_other;
+	/** Histograms of illegal instruction traps indexed by major opcode */
+	struct sbi_latency_hist illegal[SBI_LATENCY_ILLEGAL_OPS];
+	/** Histogram of traps which ended up redirected to S/U-mode */
+	struct sbi_latency_hist redirect;
+};
+
+struct sbi_scratch;
+
+#ifdef CONFIG_SBI_LATENCY_HIST
+
+/** Get the start timestamp of a latency measurement */
+static inline unsigned long sbi_latency_start(void)
+{
+	return csr_read(CSR_MCYCLE);
+}
+
+void sbi_latency_ecall_record(unsigned long extid, unsigned long funcid,
+			      unsigned long start);
+
+void sbi_latency_note_illegal(unsigned long insn);
+
+void sbi_latency_note_redirect(void);
+
+void sbi_latency_trap_record(unsigned long mcause, unsigned long start);
+
+const struct sbi_latency_stats *sbi_latency_get_stats(u32 hartindex);
+
+void sbi_latency_dump(u32 hartindex);
+
+void sbi_latency_dump_all(void);
+
+int sbi_latency_init(struct sbi_scratch *scratch, bool cold_boot);
+
+#else
+
+static inline unsigned long sbi_latency_start(void) { return 0; }
+
+static inline void sbi_latency_ecall_record(unsigned long extid,
+					    unsigned long funcid,
+					    unsigned long start) { }
+
+static inline void sbi_latency_note_illegal(unsigned long insn) { }
+
+static inline void sbi_latency_note_redirect(void) { }
+
+static inline void sbi_latency_trap_record(unsigned long mcause,
+					   unsigned long start) { }
+
+static inline const struct sbi_latency_stats *
+sbi_latency_get_stats(u32 hartindex)
+{
+	return NULL;
+}
+
+static inline void sbi_latency_dump(u32 hartindex) { }
+
+static inline void sbi_latency_dump_all(void) { }
+
+static inline int sbi_latency_init(struct sbi_scratch *scratch,
+				   bool cold_boot) { return 0; }
+
+#endif
+
+#endif
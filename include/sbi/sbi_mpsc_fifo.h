@@ -0,0 +1,49 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 Sophgo Technology Inc.
+ */
+
+#ifndef __SBI_MPSC_FIFO_H__
+#define __SBI_MPSC_FIFO_H__
+
+#include <sbi/riscv_atomic.h>
+#include <sbi/sbi_types.h>
+
+/**
+ * Lock-free multi-producer single-consumer FIFO
+ *
+ * Producers reserve a slot by atomically advancing the head and publish
+ * the slot through a per-slot sequence number. The single consumer (the
+ * HART owning the FIFO) claims published slots without taking any lock.
+ *
+ * Slot sequence numbers follow these rules, with pos being the monotonic
+ * position of the slot and N the number of entries:
+ *   seq == pos       : slot is free for the producer at pos
+ *   seq == pos + 1   : slot holds a published entry
+ *   seq == pos + N   : slot was consumed, free for the producer at pos + N
+ *   seq == BUSY      : slot is temporarily claimed for read or update
+ */
+struct sbi_mpsc_fifo {
+	void *queue;
+	atomic_t *seq;
+	atomic_t head;
+	unsigned long tail;
+	u16 entry_size;
+	u16 num_entries;
+};
+
+/** Size of memory required for a FIFO with given entries and entry size */
+#define SBI_MPSC_FIFO_MEM_SIZE(__entries, __entry_size)			\
+	((size_t)(__entries) * (sizeof(atomic_t) + (__entry_size)))
+
+void sbi_mpsc_fifo_init(struct sbi_mpsc_fifo *fifo, void *mem, u16 entries,
+			u16 entry_size);
+int sbi_mpsc_fifo_enqueue(struct sbi_mpsc_fifo *fifo, void *data);
+int sbi_mpsc_fifo_dequeue(struct sbi_mpsc_fifo *fifo, void *data);
+int sbi_mpsc_fifo_inplace_update(struct sbi_mpsc_fifo *fifo, void *in,
+				 int (*fptr)(void *in, void *data));
+bool sbi_mpsc_fifo_is_empty(struct sbi_mpsc_fifo *fifo);
+void sbi_mpsc_fifo_wait_space(struct sbi_mpsc_fifo *fifo);
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 Sophgo Technology Inc.
+ */
+
+#ifndef __SBI_PROFILE_H__
+#define __SBI_PROFILE_H__
+
+#include <sbi/sbi_types.h>
+
+/* clang-format off */
+
+/** Number of return addresses recorded per sample (including the PC) */
+#define SBI_PROFILE_DEPTH		4
+
+/* clang-format on */
+
+/** Sample of the M-mode call chain */
+struct sbi_profile_sample {
+	/** mcause of the trap being handled when the sample was taken */
+	unsigned long cause;
+	/** Sampled PC followed by the return addresses of its callers */
+	unsigned long pc[SBI_PROFILE_DEPTH];
+};
+
+/**
+ * Profiling window opened by sbi_profile_enter()
+ *
+ * A sample trap nested in the window overwrites the trap CSRs of the
+ * trap being handled, so the window saves them and sbi_profile_exit()
+ * puts them back.
+ */
+struct sbi_profile_window {
+	/** True if the window enabled M-mode interrupts */
+	bool open;
+	unsigned long mepc;
+	unsigned long mcause;
+	unsigned long mtval;
+	unsigned long mstatus;
+#if __riscv_xlen == 32
+	unsigned long mstatusH;
+#endif
+};
+
+struct sbi_scratch;
+struct sbi_trap_context;
+
+#ifdef CONFIG_SBI_PROFILER
+
+void sbi_profile_enter(struct sbi_profile_window *win);
+
+void sbi_profile_exit(struct sbi_profile_window *win);
+
+bool sbi_profile_sample(struct sbi_trap_context *tcntx);
+
+void sbi_profile_dump(void);
+
+int sbi_profile_init(struct sbi_scratch *scratch, bool cold_boot);
+
+#else
+
+static inline void sbi_profile_enter(struct sbi_profile_window *win) { }
+
+static inline void sbi_profile_exit(struct sbi_profile_window *win) { }
+
+static inline bool sbi_profile_sample(struct sbi_trap_context *tcntx)
+{
+	return false;
+}
+
+static inline void sbi_profile_dump(void) { }
+
+static inline int sbi_profile_init(struct sbi_scratch *scratch,
+				   bool cold_boot) { return 0; }
+
+#endif
+
+#endif
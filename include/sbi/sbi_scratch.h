@@ -44,8 +44,12 @@
 #define SBI_SCRATCH_OPTIONS_OFFSET		(13 * __SIZEOF_POINTER__)
 /** Offset of hartindex member in sbi_scratch */
 #define SBI_SCRATCH_HARTINDEX_OFFSET		(14 * __SIZEOF_POINTER__)
+/** Offset of fast_timecmp member in sbi_scratch */
+#define SBI_SCRATCH_FAST_TIMECMP_OFFSET		(15 * __SIZEOF_POINTER__)
+/** Value of fast_timecmp for the SET_TIMER fast path to write stimecmp */
+#define SBI_SCRATCH_FAST_TIMECMP_SSTC		1
 /** Offset of extra space in sbi_scratch */
-#define SBI_SCRATCH_EXTRA_SPACE_OFFSET		(15 * __SIZEOF_POINTER__)
+#define SBI_SCRATCH_EXTRA_SPACE_OFFSET		(16 * __SIZEOF_POINTER__)
 /** Maximum size of sbi_scratch (4KB) */
 #define SBI_SCRATCH_SIZE			(0x1000)
 
@@ -87,6 +91,11 @@ struct sbi_scratch {
 	unsigned long options;
 	/** Index of the hart */
 	unsigned long hartindex;
+	/**
+	 * Timer compare register used by the SET_TIMER fast path (or 0),
+	 * SBI_SCRATCH_FAST_TIMECMP_SSTC to write stimecmp instead
+	 */
+	unsigned long fast_timecmp;
 };
 
 /**
@@ -108,6 +117,7 @@ assert_member_offset(struct sbi_scratch, trap_context, SBI_SCRATCH_TRAP_CONTEXT_
 assert_member_offset(struct sbi_scratch, tmp0, SBI_SCRATCH_TMP0_OFFSET);
 assert_member_offset(struct sbi_scratch, options, SBI_SCRATCH_OPTIONS_OFFSET);
 assert_member_offset(struct sbi_scratch, hartindex, SBI_SCRATCH_HARTINDEX_OFFSET);
+assert_member_offset(struct sbi_scratch, fast_timecmp, SBI_SCRATCH_FAST_TIMECMP_OFFSET);
 
 /** Possible options for OpenSBI library */
 enum sbi_scratch_options {
@@ -203,6 +213,34 @@ extern struct sbi_scratch *hartindex_to_scratch_table[];
 	hartindex_to_scratch_table[__hartindex] : NULL;	\
 })
 
+/** Number of bits in the slot index of a HART id to HART index map */
+#define SBI_HARTID_MAP_BITS		8
+/** Number of slots in a HART id to HART index map */
+#define SBI_HARTID_MAP_SIZE		(1U << SBI_HARTID_MAP_BITS)
+
+/**
+ * Reverse map from HART id to HART index
+ *
+ * When all HART ids are below SBI_HARTID_MAP_SIZE the map is a direct
+ * array indexed by HART id. Otherwise HART ids are hashed into an open
+ * addressing table kept at most half full so lookups probe a few slots.
+ */
+struct sbi_hartid_map {
+	/** Map has been built */
+	bool ready;
+	/** Slots are indexed by HART id instead of by hash */
+	bool direct;
+	/** HART id stored in each slot (-1U if free), unused when direct */
+	u32 hartid[SBI_HARTID_MAP_SIZE];
+	/** HART index stored in each slot (-1 if free) */
+	u16 hartindex[SBI_HARTID_MAP_SIZE];
+};
+
+int sbi_hartid_map_build(struct sbi_hartid_map *map, const u32 *hartids,
+			 u32 count);
+
+u32 sbi_hartid_map_lookup(const struct sbi_hartid_map *map, u32 hartid);
+
 /**
  * Get logical index for given HART id
  * @param hartid physical HART id
@@ -10,6 +10,7 @@
 #ifndef __SBI_TIMER_H__
 #define __SBI_TIMER_H__
 
+#include <sbi/sbi_list.h>
 #include <sbi/sbi_types.h>
 
 /** Timer hardware device */
@@ -29,10 +30,62 @@ struct sbi_timer_device {
 	/** Stop timer event for current HART */
 	void (*timer_event_stop)(void);
 
+	/**
+	 * Get the 64-bit timer compare register of current HART if a
+	 * single 64-bit store to it starts a timer event (optional)
+	 */
+	void *(*timer_event_fast_cmp)(void);
+
 	/** Initialize timer device for current HART */
 	int (*warm_init)(void);
 };
 
+/**
+ * M-mode timer event
+ *
+ * Timer events are per-HART and share the timer compare register of
+ * the HART with the supervisor timer. The callback is called in M-mode
+ * from the timer interrupt of the HART which added the event, and may
+ * add the event again.
+ */
+struct sbi_timer_event {
+	/** List node (internal) */
+	struct sbi_dlist node;
+	/** Expiry time in timer ticks (internal) */
+	u64 expires;
+	/** Callback called once the event expires */
+	void (*callback)(struct sbi_timer_event *ev);
+	/** Private data of the event owner */
+	void *priv;
+};
+
+/** Initialize a timer event */
+static inline void sbi_timer_event_init(struct sbi_timer_event *ev,
+					void (*callback)(struct sbi_timer_event *),
+					void *priv)
+{
+	SBI_INIT_LIST_HEAD(&ev->node);
+	ev->expires = 0;
+	ev->callback = callback;
+	ev->priv = priv;
+}
+
+/** Check whether a timer event is waiting to expire */
+static inline bool sbi_timer_event_pending(struct sbi_timer_event *ev)
+{
+	return !sbi_list_empty(&ev->node);
+}
+
+/** Supervisor timer compare writes done and skipped by coalescing */
+struct sbi_timer_coalesce_stats {
+	/** Compare register writes for supervisor deadlines */
+	u64 writes;
+	/** Writes skipped because the deadline was within the slack */
+	u64 skipped_slack;
+	/** Writes skipped because an earlier deadline was still armed */
+	u64 skipped_later;
+};
+
 struct sbi_scratch;
 
 /** Generic delay loop of desired granularity */
@@ -92,6 +145,23 @@ void sbi_timer_event_start(u64 next_event);
 /** Process timer event for current HART */
 void sbi_timer_process(void);
 
+/** Get timer coalescing statistics of a HART (NULL if not enabled) */
+const struct sbi_timer_coalesce_stats *
+sbi_timer_get_coalesce_stats(u32 hartindex);
+
+#ifdef CONFIG_SBI_ECALL_FAST_TIMER
+/** Allow or block the set_timer ecall fast path on current HART */
+void sbi_timer_fast_path_allow(bool allow);
+#else
+static inline void sbi_timer_fast_path_allow(bool allow) { }
+#endif
+
+/** Add (or move) an M-mode timer event of current HART */
+int sbi_timer_add_event(struct sbi_timer_event *ev, u64 expires);
+
+/** Remove an M-mode timer event of current HART if pending */
+void sbi_timer_del_event(struct sbi_timer_event *ev);
+
 /** Get current timer device */
 const struct sbi_timer_device *sbi_timer_get_device(void);
 
@@ -36,6 +36,8 @@ enum sbi_tlb_type {
 struct sbi_tlb_info {
 	unsigned long start;
 	unsigned long size;
+	/** FENCE.I epoch of the request (assigned by sbi_tlb_request) */
+	unsigned long epoch;
 	uint16_t asid;
 	uint16_t vmid;
 	enum sbi_tlb_type type;
@@ -46,6 +48,7 @@ struct sbi_tlb_info {
 do { \
 	(__p)->start = (__start); \
 	(__p)->size = (__size); \
+	(__p)->epoch = 0; \
 	(__p)->asid = (__asid); \
 	(__p)->vmid = (__vmid); \
 	(__p)->type = (__type); \
@@ -54,8 +57,37 @@ do { \
 
 #define SBI_TLB_INFO_SIZE		sizeof(struct sbi_tlb_info)
 
+/*
+ * Requests targeting at least this many harts are published once as a
+ * shared broadcast descriptor instead of being copied into every target
+ * hart's fifo.
+ */
+#define SBI_TLB_BCAST_MIN_TARGETS	4
+
+/**
+ * Remote fence statistics of a sending hart, indexed by fence type
+ *
+ * This is also the layout of the snapshot copied into supervisor memory
+ * by the SBI_EXT_OPENSBI_TLB_STATS function.
+ */
+struct sbi_tlb_coalesce_stats {
+	/** Per-target requests queued as a new entry in the target's fifo */
+	unsigned long queued[SBI_TLB_TYPE_MAX];
+	/** Per-target requests merged into an entry pending in the target's fifo */
+	unsigned long merged[SBI_TLB_TYPE_MAX];
+	/** Requests published once as a broadcast descriptor */
+	unsigned long broadcast[SBI_TLB_TYPE_MAX];
+	/** Per-target requests already satisfied by the target (FENCE.I) */
+	unsigned long elided[SBI_TLB_TYPE_MAX];
+	/** Cycles spent sending broadcasts and waiting for their completion */
+	unsigned long broadcast_cycles[SBI_TLB_TYPE_MAX];
+};
+
 int sbi_tlb_request(ulong hmask, ulong hbase, struct sbi_tlb_info *tinfo);
 
+const struct sbi_tlb_coalesce_stats *
+sbi_tlb_get_coalesce_stats(u32 hartindex);
+
 int sbi_tlb_init(struct sbi_scratch *scratch, bool cold_boot);
 
 #endif
@@ -39,6 +39,24 @@ struct sbiunit_test_suite {
 		.cases = cases_arr				\
 	}
 
+/** Number of operations timed by each benchmark */
+#define SBIUNIT_BENCH_ROUNDS	1024
+
+struct sbiunit_bench {
+	const char *name;
+	/* Prepare the benchmark, not timed (optional) */
+	void (*init)(void);
+	/* Run the benchmarked operation the given number of times */
+	void (*run)(unsigned long rounds);
+};
+
+#define SBIUNIT_BENCH(bench_name, init_func, run_func)		\
+	struct sbiunit_bench bench_name = {			\
+		.name = #bench_name,				\
+		.init = (init_func),				\
+		.run = (run_func)				\
+	}
+
 #define _sbiunit_msg(test, msg) "[SBIUnit] [%s:%d]: %s: %s", __FILE__,	\
 				__LINE__, test->name, msg
 
@@ -15,6 +15,9 @@
 struct sbi_scratch;
 struct sbi_trap_info;
 
+/** Number of words accessed within one MPRV window by bulk copies */
+#define SBI_UNPRIV_WINDOW_WORDS		4
+
 #define DECLARE_UNPRIVILEGED_LOAD_FUNCTION(type)           \
 	type sbi_load_##type(const type *addr,             \
 			     struct sbi_trap_info *trap);
@@ -38,4 +41,10 @@ DECLARE_UNPRIVILEGED_LOAD_FUNCTION(ulong)
 
 ulong sbi_get_insn(ulong mepc, struct sbi_trap_info *trap);
 
+void sbi_load_bytes(u8 *dst, ulong addr, ulong len,
+		    struct sbi_trap_info *trap);
+
+void sbi_store_bytes(ulong addr, const u8 *src, ulong len,
+		     struct sbi_trap_info *trap);
+
 #endif
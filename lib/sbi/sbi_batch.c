@@ -0,0 +1,178 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 Sophgo Technology Inc.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/sbi_batch.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_ecall.h>
+#include <sbi/sbi_ecall_interface.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hart.h>
+#include <sbi/sbi_latency.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_trap.h>
+
+struct batch_shmem {
+	unsigned long addr;
+	unsigned long num_entries;
+};
+
+static unsigned long batch_shmem_off;
+
+static struct batch_shmem *batch_thishart_shmem(void)
+{
+	return sbi_scratch_thishart_offset_ptr(batch_shmem_off);
+}
+
+/*
+ * Only extensions whose handlers act purely on their arguments and
+ * return normally can be batched. Anything that stops or suspends the
+ * HART, redirects the trap or touches supervisor memory itself (which
+ * would need a second shared memory mapping) is rejected.
+ */
+static bool batch_extid_allowed(unsigned long extid)
+{
+	switch (extid) {
+	case SBI_EXT_BASE:
+	case SBI_EXT_TIME:
+	case SBI_EXT_IPI:
+	case SBI_EXT_RFENCE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+int sbi_batch_set_shmem(unsigned long addr_lo, unsigned long addr_hi,
+			unsigned long num_entries)
+{
+	ulong smode = (csr_read(CSR_MSTATUS) & MSTATUS_MPP) >>
+			MSTATUS_MPP_SHIFT;
+	struct batch_shmem *shmem = batch_thishart_shmem();
+
+	if (addr_lo == -1UL && addr_hi == -1UL) {
+		shmem->addr = 0;
+		shmem->num_entries = 0;
+		return 0;
+	}
+
+	/* Same physical address restrictions as the DBCN extension */
+	if (addr_hi)
+		return SBI_EINVALID_ADDR;
+	if (!num_entries || num_entries > SBI_BATCH_MAX_ENTRIES ||
+	    (addr_lo & (sizeof(unsigned long) - 1)))
+		return SBI_EINVAL;
+
+	if (!sbi_domain_check_addr_range(sbi_domain_thishart_ptr(), addr_lo,
+				num_entries * sizeof(struct sbi_batch_entry),
+				smode, SBI_DOMAIN_READ | SBI_DOMAIN_WRITE))
+		return SBI_EINVALID_ADDR;
+
+	shmem->addr = addr_lo;
+	shmem->num_entries = num_entries;
+
+	return 0;
+}
+
+static void batch_exec_one(struct sbi_batch_entry *entry)
+{
+	struct sbi_ecall_extension *ext;
+	struct sbi_ecall_return out = {0};
+	struct sbi_trap_regs regs = {0};
+	unsigned long start = sbi_latency_start();
+	int ret;
+
+	if (!batch_extid_allowed(entry->extid)) {
+		entry->error = SBI_ERR_NOT_SUPPORTED;
+		entry->value = 0;
+		return;
+	}
+
+	ext = sbi_ecall_find_extension(entry->extid);
+	if (!ext || !ext->handle) {
+		entry->error = SBI_ERR_NOT_SUPPORTED;
+		entry->value = 0;
+		return;
+	}
+
+	regs.a0 = entry->args[0];
+	regs.a1 = entry->args[1];
+	regs.a2 = entry->args[2];
+	regs.a3 = entry->args[3];
+	regs.a4 = entry->args[4];
+	regs.a5 = entry->args[5];
+	regs.a6 = entry->funcid;
+	regs.a7 = entry->extid;
+	regs.mstatus = csr_read(CSR_MSTATUS);
+
+	ret = ext->handle(entry->extid, entry->funcid, &regs, &out);
+	sbi_latency_ecall_record(entry->extid, entry->funcid, start);
+
+	if (ret < SBI_LAST_ERR || SBI_SUCCESS < ret)
+		ret = SBI_ERR_FAILED;
+	entry->error = ret;
+	entry->value = out.value;
+}
+
+/**
+ * Execute count entries of the calling HART's batch ring starting at
+ * index first, wrapping around at the end of the ring.
+ *
+ * Each entry is copied into M-mode before its handler runs so that
+ * handlers never run with the shared memory mapped.
+ */
+int sbi_batch_exec(unsigned long first, unsigned long count,
+		   struct sbi_ecall_return *out)
+{
+	struct batch_shmem *shmem = batch_thishart_shmem();
+	struct sbi_batch_entry entry, *ring;
+	unsigned long i, idx;
+
+	if (!shmem->num_entries)
+		return SBI_ENO_SHMEM;
+	if (first >= shmem->num_entries || count > shmem->num_entries)
+		return SBI_EINVAL;
+
+	ring = (struct sbi_batch_entry *)shmem->addr;
+	for (i = 0; i < count; i++) {
+		idx = (first + i) % shmem->num_entries;
+
+		sbi_hart_map_saddr((unsigned long)&ring[idx], sizeof(entry));
+		sbi_memcpy(&entry, &ring[idx], sizeof(entry));
+		sbi_hart_unmap_saddr();
+
+		batch_exec_one(&entry);
+
+		sbi_hart_map_saddr((unsigned long)&ring[idx], sizeof(entry));
+		ring[idx].error = entry.error;
+		ring[idx].value = entry.value;
+		sbi_hart_unmap_saddr();
+	}
+
+	out->value = count;
+	return 0;
+}
+
+int sbi_batch_init(struct sbi_scratch *scratch, bool cold_boot)
+{
+	struct batch_shmem *shmem;
+
+	if (cold_boot) {
+		batch_shmem_off = sbi_scratch_alloc_offset(sizeof(*shmem));
+		if (!batch_shmem_off)
+			return SBI_ENOMEM;
+	} else if (!batch_shmem_off) {
+		return SBI_ENOMEM;
+	}
+
+	/* A (re)started HART always starts without shared memory */
+	shmem = sbi_scratch_offset_ptr(scratch, batch_shmem_off);
+	shmem->addr = 0;
+	shmem->num_entries = 0;
+
+	return 0;
+}
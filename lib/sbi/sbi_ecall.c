@@ -7,10 +7,13 @@
  *   Anup Patel <anup.patel@wdc.com>
  */
 
+#include <sbi/riscv_barrier.h>
+#include <sbi/riscv_locks.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_ecall.h>
 #include <sbi/sbi_ecall_interface.h>
 #include <sbi/sbi_error.h>
+#include <sbi/sbi_latency.h>
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_trap.h>
 
@@ -40,18 +43,158 @@ void sbi_ecall_set_impid(unsigned long impid)
 
 static SBI_LIST_HEAD(ecall_exts_list);
 
-struct sbi_ecall_extension *sbi_ecall_find_extension(unsigned long extid)
+/* clang-format off */
+
+#define ECALL_DISPATCH_MAX_RANGES	64
+#define ECALL_DISPATCH_HASH_BITS	6
+#define ECALL_DISPATCH_HASH_SIZE	(1U << ECALL_DISPATCH_HASH_BITS)
+
+/* clang-format on */
+
+/**
+ * Extension lookup structure built from the extension list
+ *
+ * Extensions registered for a single extension ID (most standard ones)
+ * are also placed in a direct-mapped table indexed by a hash of the ID.
+ * Every registered range is kept in an array sorted by start ID which is
+ * binary searched when the direct-mapped slot does not match.
+ */
+struct ecall_dispatch {
+	u32 count;
+	bool overflow;
+	struct sbi_ecall_extension *direct[ECALL_DISPATCH_HASH_SIZE];
+	struct sbi_ecall_extension *sorted[ECALL_DISPATCH_MAX_RANGES];
+};
+
+/*
+ * Extensions can be registered or unregistered at runtime while other
+ * harts look them up. Changes to the extension list and rebuilds of the
+ * lookup structure are serialized by ecall_dispatch_lock. The sequence
+ * count is odd while a rebuild is in progress, and lookups overlapping
+ * a rebuild are retried, so they never use a half-built structure.
+ */
+static spinlock_t ecall_dispatch_lock = SPIN_LOCK_INITIALIZER;
+static unsigned long ecall_dispatch_seq;
+static bool ecall_dispatch_ready;
+static struct ecall_dispatch ecall_dispatch;
+
+static inline u32 ecall_dispatch_hash(unsigned long extid)
 {
-	struct sbi_ecall_extension *t, *ret = NULL;
+	return ((u32)extid * 0x9e3779b1U) >> (32 - ECALL_DISPATCH_HASH_BITS);
+}
+
+/* Must be called with ecall_dispatch_lock held */
+static void ecall_dispatch_build(void)
+{
+	u32 i, slot;
+	struct sbi_ecall_extension *t;
+	struct ecall_dispatch *d = &ecall_dispatch;
+
+	ecall_dispatch_seq++;
+	smp_wmb();
+
+	sbi_memset(d, 0, sizeof(*d));
 
 	sbi_list_for_each_entry(t, &ecall_exts_list, head) {
-		if (t->extid_start <= extid && extid <= t->extid_end) {
-			ret = t;
+		if (d->count == ECALL_DISPATCH_MAX_RANGES) {
+			/* Lookups fall back to walking the list */
+			d->overflow = true;
 			break;
 		}
+
+		/* Insertion sort, ranges never overlap */
+		for (i = d->count; i && d->sorted[i - 1]->extid_start >
+					t->extid_start; i--)
+			d->sorted[i] = d->sorted[i - 1];
+		d->sorted[i] = t;
+		d->count++;
+
+		slot = ecall_dispatch_hash(t->extid_start);
+		if (t->extid_start == t->extid_end && !d->direct[slot])
+			d->direct[slot] = t;
 	}
 
-	return ret;
+	smp_wmb();
+	ecall_dispatch_seq++;
+	ecall_dispatch_ready = true;
+}
+
+static struct sbi_ecall_extension *ecall_list_find(unsigned long extid)
+{
+	struct sbi_ecall_extension *t;
+
+	sbi_list_for_each_entry(t, &ecall_exts_list, head) {
+		if (t->extid_start <= extid && extid <= t->extid_end)
+			return t;
+	}
+
+	return NULL;
+}
+
+/*
+ * Look up extid in the dispatch structure. Returns false when a rebuild
+ * was observed through a missing entry and the lookup must be retried.
+ */
+static bool ecall_dispatch_find(unsigned long extid,
+				struct sbi_ecall_extension **out)
+{
+	struct ecall_dispatch *d = &ecall_dispatch;
+	struct sbi_ecall_extension *t;
+	u32 lo, hi, mid;
+
+	*out = NULL;
+
+	t = d->direct[ecall_dispatch_hash(extid)];
+	if (t && t->extid_start == extid) {
+		*out = t;
+		return true;
+	}
+
+	lo = 0;
+	hi = MIN(d->count, (u32)ECALL_DISPATCH_MAX_RANGES);
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		t = d->sorted[mid];
+		if (!t)
+			return false;
+		if (extid < t->extid_start) {
+			hi = mid;
+		} else if (t->extid_end < extid) {
+			lo = mid + 1;
+		} else {
+			*out = t;
+			break;
+		}
+	}
+
+	return true;
+}
+
+struct sbi_ecall_extension *sbi_ecall_find_extension(unsigned long extid)
+{
+	struct sbi_ecall_extension *t;
+	unsigned long seq;
+	bool found;
+
+	if (!__smp_load_acquire(&ecall_dispatch_ready))
+		return ecall_list_find(extid);
+
+	do {
+		while ((seq = __smp_load_acquire(&ecall_dispatch_seq)) & 1)
+			cpu_relax();
+
+		if (ecall_dispatch.overflow) {
+			spin_lock(&ecall_dispatch_lock);
+			t = ecall_list_find(extid);
+			spin_unlock(&ecall_dispatch_lock);
+			return t;
+		}
+
+		found = ecall_dispatch_find(extid, &t);
+		smp_rmb();
+	} while (!found || seq != *(volatile unsigned long *)&ecall_dispatch_seq);
+
+	return t;
 }
 
 void sbi_ecall_get_extensions_str(char *exts_str, int exts_str_size, bool experimental)
@@ -84,17 +227,27 @@ int sbi_ecall_register_extension(struct sbi_ecall_extension *ext)
 	if (!ext || (ext->extid_end < ext->extid_start) || !ext->handle)
 		return SBI_EINVAL;
 
+	spin_lock(&ecall_dispatch_lock);
+
 	sbi_list_for_each_entry(t, &ecall_exts_list, head) {
 		unsigned long start = t->extid_start;
 		unsigned long end = t->extid_end;
 		if (end < ext->extid_start || ext->extid_end < start)
 			/* no overlap */;
-		else
+		else {
+			spin_unlock(&ecall_dispatch_lock);
 			return SBI_EINVAL;
+		}
 	}
 
 	sbi_list_add_tail(&ext->head, &ecall_exts_list);
 
+	/* Before sbi_ecall_init() completes the list is walked instead */
+	if (ecall_dispatch_ready)
+		ecall_dispatch_build();
+
+	spin_unlock(&ecall_dispatch_lock);
+
 	return 0;
 }
 
@@ -106,6 +259,8 @@ void sbi_ecall_unregister_extension(struct sbi_ecall_extension *ext)
 	if (!ext)
 		return;
 
+	spin_lock(&ecall_dispatch_lock);
+
 	sbi_list_for_each_entry(t, &ecall_exts_list, head) {
 		if (t == ext) {
 			found = true;
@@ -113,8 +268,13 @@ void sbi_ecall_unregister_extension(struct sbi_ecall_extension *ext)
 		}
 	}
 
-	if (found)
+	if (found) {
 		sbi_list_del_init(&ext->head);
+		if (ecall_dispatch_ready)
+			ecall_dispatch_build();
+	}
+
+	spin_unlock(&ecall_dispatch_lock);
 }
 
 int sbi_ecall_handler(struct sbi_trap_context *tcntx)
@@ -126,10 +286,12 @@ int sbi_ecall_handler(struct sbi_trap_context *tcntx)
 	unsigned long func_id = regs->a6;
 	struct sbi_ecall_return out = {0};
 	bool is_0_1_spec = 0;
+	unsigned long start = sbi_latency_start();
 
 	ext = sbi_ecall_find_extension(extension_id);
 	if (ext && ext->handle) {
 		ret = ext->handle(extension_id, func_id, regs, &out);
+		sbi_latency_ecall_record(extension_id, func_id, start);
 		if (extension_id >= SBI_EXT_0_1_SET_TIMER &&
 		    extension_id <= SBI_EXT_0_1_SHUTDOWN)
 			is_0_1_spec = 1;
@@ -180,5 +342,9 @@ int sbi_ecall_init(void)
 			return ret;
 	}
 
+	spin_lock(&ecall_dispatch_lock);
+	ecall_dispatch_build();
+	spin_unlock(&ecall_dispatch_lock);
+
 	return 0;
 }
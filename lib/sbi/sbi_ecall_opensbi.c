@@ -0,0 +1,112 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 Sophgo Technology Inc.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/sbi_batch.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_ecall.h>
+#include <sbi/sbi_ecall_interface.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hart.h>
+#include <sbi/sbi_latency.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_timer.h>
+#include <sbi/sbi_tlb.h>
+#include <sbi/sbi_trap.h>
+
+/**
+ * Copy per-HART data into supervisor memory
+ *
+ * The HART must belong to the domain of the calling HART and the output
+ * buffer of size bytes at (addr_hi:addr_lo) must be writable by the
+ * calling supervisor.
+ */
+static int opensbi_copy_to_smode(u32 hartindex, const void *data, size_t len,
+				 unsigned long addr_lo, unsigned long addr_hi,
+				 unsigned long size)
+{
+	ulong smode = (csr_read(CSR_MSTATUS) & MSTATUS_MPP) >>
+			MSTATUS_MPP_SHIFT;
+
+	if (!sbi_hartindex_valid(hartindex) ||
+	    !sbi_domain_is_assigned_hart(sbi_domain_thishart_ptr(), hartindex))
+		return SBI_EINVAL;
+	if (!data)
+		return SBI_ENOTSUPP;
+
+	/* Same physical address restrictions as the DBCN extension */
+	if (addr_hi)
+		return SBI_EFAIL;
+	if (size < len)
+		return SBI_EINVAL;
+
+	if (!sbi_domain_check_addr_range(sbi_domain_thishart_ptr(),
+					 addr_lo, len, smode,
+					 SBI_DOMAIN_READ | SBI_DOMAIN_WRITE))
+		return SBI_EINVALID_ADDR;
+
+	sbi_hart_map_saddr(addr_lo, len);
+	sbi_memcpy((void *)addr_lo, data, len);
+	sbi_hart_unmap_saddr();
+
+	return 0;
+}
+
+static int sbi_ecall_opensbi_handler(unsigned long extid, unsigned long funcid,
+				     struct sbi_trap_regs *regs,
+				     struct sbi_ecall_return *out)
+{
+	u32 hartindex = sbi_hartid_to_hartindex(regs->a0);
+
+	/*
+	 * The statistics functions take the HART id in a0, the lower/upper
+	 * bits of the physical address of the output buffer in a1/a2 and
+	 * the size of the output buffer in a3.
+	 */
+	switch (funcid) {
+	case SBI_EXT_OPENSBI_LATENCY_SNAPSHOT:
+		return opensbi_copy_to_smode(hartindex,
+				sbi_latency_get_stats(hartindex),
+				sizeof(struct sbi_latency_stats),
+				regs->a1, regs->a2, regs->a3);
+	case SBI_EXT_OPENSBI_TIMER_STATS:
+		return opensbi_copy_to_smode(hartindex,
+				sbi_timer_get_coalesce_stats(hartindex),
+				sizeof(struct sbi_timer_coalesce_stats),
+				regs->a1, regs->a2, regs->a3);
+	case SBI_EXT_OPENSBI_TLB_STATS:
+		return opensbi_copy_to_smode(hartindex,
+				sbi_tlb_get_coalesce_stats(hartindex),
+				sizeof(struct sbi_tlb_coalesce_stats),
+				regs->a1, regs->a2, regs->a3);
+#ifdef CONFIG_SBI_BATCH
+	case SBI_EXT_OPENSBI_BATCH_SET_SHMEM:
+		return sbi_batch_set_shmem(regs->a0, regs->a1, regs->a2);
+	case SBI_EXT_OPENSBI_BATCH_EXEC:
+		return sbi_batch_exec(regs->a0, regs->a1, out);
+#endif
+	default:
+		break;
+	}
+
+	return SBI_ENOTSUPP;
+}
+
+struct sbi_ecall_extension ecall_opensbi;
+
+static int sbi_ecall_opensbi_register_extensions(void)
+{
+	return sbi_ecall_register_extension(&ecall_opensbi);
+}
+
+struct sbi_ecall_extension ecall_opensbi = {
+	.name			= "opensbi",
+	.extid_start		= SBI_EXT_OPENSBI,
+	.extid_end		= SBI_EXT_OPENSBI,
+	.register_extensions	= sbi_ecall_opensbi_register_extensions,
+	.handle			= sbi_ecall_opensbi_handler,
+};
@@ -17,38 +17,154 @@
 #include <sbi/sbi_timer.h>
 #include <sbi/sbi_trap.h>
 
-static bool hpm_allowed(int hpm_num, ulong prev_mode, bool virt)
+/** Per-HART user counters resolved in advance for emulation */
+struct emulate_csr_counters {
+	/** Counters which are emulated (not implemented by hardware) */
+	unsigned long emulated;
+	/** Emulated counters which mcounteren allows for S/U-mode */
+	unsigned long smode;
+};
+
+static unsigned long emulate_counters_off;
+
+typedef ulong (*counter_read_func)(int idx, bool virt);
+
+static ulong counter_read_cycle(int idx, bool virt)
 {
-	ulong cen = -1UL;
-	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
-
-	if (prev_mode <= PRV_S) {
-		if (sbi_hart_priv_version(scratch) >= SBI_HART_PRIV_VER_1_10) {
-			cen &= csr_read(CSR_MCOUNTEREN);
-			if (virt)
-				cen &= csr_read(CSR_HCOUNTEREN);
-		} else {
-			cen = 0;
-		}
-	}
-	if (prev_mode == PRV_U) {
-		if (sbi_hart_priv_version(scratch) >= SBI_HART_PRIV_VER_1_10)
+	return csr_read(CSR_MCYCLE);
+}
+
+static ulong counter_read_time(int idx, bool virt)
+{
+	/*
+	 * We emulate TIME CSR for both Host (HS/U-mode) and
+	 * Guest (VS/VU-mode).
+	 */
+	return (virt) ? sbi_timer_virt_value() : sbi_timer_value();
+}
+
+static ulong counter_read_instret(int idx, bool virt)
+{
+	return csr_read(CSR_MINSTRET);
+}
+
+static ulong counter_read_hpm(int idx, bool virt)
+{
+	return csr_read_num(CSR_MCYCLE + idx);
+}
+
+/* Indexed by the user counter CSR number minus CSR_CYCLE */
+static const counter_read_func counter_read_table[32] = {
+	[0]		= counter_read_cycle,
+	[1]		= counter_read_time,
+	[2]		= counter_read_instret,
+	[3 ... 31]	= counter_read_hpm,
+};
+
+#if __riscv_xlen == 32
+static ulong counter_read_cycleh(int idx, bool virt)
+{
+	return csr_read(CSR_MCYCLEH);
+}
+
+static ulong counter_read_timeh(int idx, bool virt)
+{
+	/* Refer comments on TIME CSR above. */
+	return (virt) ? sbi_timer_virt_value() >> 32 :
+			sbi_timer_value() >> 32;
+}
+
+static ulong counter_read_instreth(int idx, bool virt)
+{
+	return csr_read(CSR_MINSTRETH);
+}
+
+static ulong counter_read_hpmh(int idx, bool virt)
+{
+	return csr_read_num(CSR_MCYCLEH + idx);
+}
+
+/* Indexed by the user counter CSR number minus CSR_CYCLEH */
+static const counter_read_func counter_readh_table[32] = {
+	[0]		= counter_read_cycleh,
+	[1]		= counter_read_timeh,
+	[2]		= counter_read_instreth,
+	[3 ... 31]	= counter_read_hpmh,
+};
+#endif
+
+/**
+ * Resolve the user counters emulated for the current HART.
+ *
+ * Must be called on the HART itself whenever OpenSBI changes its
+ * mcounteren. The scounteren and hcounteren CSRs are written by the
+ * supervisor without trapping, so these are still checked on each read.
+ */
+void sbi_emulate_csr_counters_update(struct sbi_scratch *scratch)
+{
+	struct emulate_csr_counters *ec;
+
+	if (!emulate_counters_off)
+		return;
+
+	ec = sbi_scratch_offset_ptr(scratch, emulate_counters_off);
+	/* CYCLE, TIME and INSTRET are never part of the mhpm_mask */
+	ec->emulated = ~(unsigned long)sbi_hart_mhpm_mask(scratch) &
+			0xffffffffUL;
+	if (sbi_hart_priv_version(scratch) >= SBI_HART_PRIV_VER_1_10)
+		ec->smode = ec->emulated & csr_read(CSR_MCOUNTEREN);
+	else
+		ec->smode = 0;
+}
+
+static int emulate_counter_read(const counter_read_func *table, int idx,
+				struct sbi_trap_regs *regs, ulong *csr_val)
+{
+	ulong prev_mode = sbi_mstatus_prev_mode(regs->mstatus);
+	bool virt = sbi_regs_from_virt(regs);
+	struct emulate_csr_counters *ec;
+	ulong cen;
+
+	if (!emulate_counters_off)
+		return SBI_ENOTSUPP;
+
+	ec = sbi_scratch_offset_ptr(sbi_scratch_thishart_ptr(),
+				    emulate_counters_off);
+	if (prev_mode == PRV_M) {
+		cen = ec->emulated;
+	} else {
+		cen = ec->smode;
+		if (virt)
+			cen &= csr_read(CSR_HCOUNTEREN);
+		if (prev_mode == PRV_U)
 			cen &= csr_read(CSR_SCOUNTEREN);
-		else
-			cen = 0;
 	}
+	if (!((cen >> idx) & 1))
+		return SBI_ENOTSUPP;
 
-	return ((cen >> hpm_num) & 1) ? true : false;
+	*csr_val = table[idx](idx, virt);
+	return 0;
 }
 
 int sbi_emulate_csr_read(int csr_num, struct sbi_trap_regs *regs,
 			 ulong *csr_val)
 {
 	int ret = 0;
-	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
 	ulong prev_mode = sbi_mstatus_prev_mode(regs->mstatus);
 	bool virt = sbi_regs_from_virt(regs);
 
+	/* User counters are dispatched through tables, see above */
+	if (CSR_CYCLE <= csr_num && csr_num <= CSR_HPMCOUNTER31)
+		return emulate_counter_read(counter_read_table,
+					    csr_num - CSR_CYCLE,
+					    regs, csr_val);
+#if __riscv_xlen == 32
+	if (CSR_CYCLEH <= csr_num && csr_num <= CSR_HPMCOUNTER31H)
+		return emulate_counter_read(counter_readh_table,
+					    csr_num - CSR_CYCLEH,
+					    regs, csr_val);
+#endif
+
 	switch (csr_num) {
 	case CSR_HTIMEDELTA:
 		if (prev_mode == PRV_S && !virt)
@@ -56,27 +172,6 @@ int sbi_emulate_csr_read(int csr_num, struct sbi_trap_regs *regs,
 		else
 			ret = SBI_ENOTSUPP;
 		break;
-	case CSR_CYCLE:
-		if (!hpm_allowed(csr_num - CSR_CYCLE, prev_mode, virt))
-			return SBI_ENOTSUPP;
-		*csr_val = csr_read(CSR_MCYCLE);
-		break;
-	case CSR_TIME:
-		if (!hpm_allowed(csr_num - CSR_CYCLE, prev_mode, virt))
-			return SBI_ENOTSUPP;
-		/*
-		 * We emulate TIME CSR for both Host (HS/U-mode) and
-		 * Guest (VS/VU-mode).
-		 */
-		*csr_val = (virt) ? sbi_timer_virt_value():
-				    sbi_timer_value();
-		break;
-	case CSR_INSTRET:
-		if (!hpm_allowed(csr_num - CSR_CYCLE, prev_mode, virt))
-			return SBI_ENOTSUPP;
-		*csr_val = csr_read(CSR_MINSTRET);
-		break;
-
 #if __riscv_xlen == 32
 	case CSR_HTIMEDELTAH:
 		if (prev_mode == PRV_S && !virt)
@@ -84,62 +179,7 @@ int sbi_emulate_csr_read(int csr_num, struct sbi_trap_regs *regs,
 		else
 			ret = SBI_ENOTSUPP;
 		break;
-	case CSR_CYCLEH:
-		if (!hpm_allowed(csr_num - CSR_CYCLEH, prev_mode, virt))
-			return SBI_ENOTSUPP;
-		*csr_val = csr_read(CSR_MCYCLEH);
-		break;
-	case CSR_TIMEH:
-		/* Refer comments on TIME CSR above. */
-		*csr_val = (virt) ? sbi_timer_virt_value() >> 32:
-				    sbi_timer_value() >> 32;
-		break;
-	case CSR_INSTRETH:
-		if (!hpm_allowed(csr_num - CSR_CYCLEH, prev_mode, virt))
-			return SBI_ENOTSUPP;
-		*csr_val = csr_read(CSR_MINSTRETH);
-		break;
-#endif
-
-#define switchcase_hpm(__uref, __mref, __csr)				\
-	case __csr:							\
-		if (sbi_hart_mhpm_mask(scratch) & (1 << (__csr - __uref)))\
-			return SBI_ENOTSUPP;				\
-		if (!hpm_allowed(__csr - __uref, prev_mode, virt))	\
-			return SBI_ENOTSUPP;				\
-		*csr_val = csr_read(__mref + __csr - __uref);		\
-		break;
-#define switchcase_hpm_2(__uref, __mref, __csr)			\
-	switchcase_hpm(__uref, __mref, __csr + 0)			\
-	switchcase_hpm(__uref, __mref, __csr + 1)
-#define switchcase_hpm_4(__uref, __mref, __csr)			\
-	switchcase_hpm_2(__uref, __mref, __csr + 0)			\
-	switchcase_hpm_2(__uref, __mref, __csr + 2)
-#define switchcase_hpm_8(__uref, __mref, __csr)			\
-	switchcase_hpm_4(__uref, __mref, __csr + 0)			\
-	switchcase_hpm_4(__uref, __mref, __csr + 4)
-#define switchcase_hpm_16(__uref, __mref, __csr)			\
-	switchcase_hpm_8(__uref, __mref, __csr + 0)			\
-	switchcase_hpm_8(__uref, __mref, __csr + 8)
-
-	switchcase_hpm(CSR_CYCLE, CSR_MCYCLE, CSR_HPMCOUNTER3)
-	switchcase_hpm_4(CSR_CYCLE, CSR_MCYCLE, CSR_HPMCOUNTER4)
-	switchcase_hpm_8(CSR_CYCLE, CSR_MCYCLE, CSR_HPMCOUNTER8)
-	switchcase_hpm_16(CSR_CYCLE, CSR_MCYCLE, CSR_HPMCOUNTER16)
-
-#if __riscv_xlen == 32
-	switchcase_hpm(CSR_CYCLEH, CSR_MCYCLEH, CSR_HPMCOUNTER3H)
-	switchcase_hpm_4(CSR_CYCLEH, CSR_MCYCLEH, CSR_HPMCOUNTER4H)
-	switchcase_hpm_8(CSR_CYCLEH, CSR_MCYCLEH, CSR_HPMCOUNTER8H)
-	switchcase_hpm_16(CSR_CYCLEH, CSR_MCYCLEH, CSR_HPMCOUNTER16H)
 #endif
-
-#undef switchcase_hpm_16
-#undef switchcase_hpm_8
-#undef switchcase_hpm_4
-#undef switchcase_hpm_2
-#undef switchcase_hpm
-
 	default:
 		ret = SBI_ENOTSUPP;
 		break;
@@ -177,3 +217,19 @@ int sbi_emulate_csr_write(int csr_num, struct sbi_trap_regs *regs,
 
 	return ret;
 }
+
+int sbi_emulate_csr_init(struct sbi_scratch *scratch, bool cold_boot)
+{
+	if (cold_boot) {
+		emulate_counters_off = sbi_scratch_alloc_offset(
+					sizeof(struct emulate_csr_counters));
+		if (!emulate_counters_off)
+			return SBI_ENOMEM;
+	} else if (!emulate_counters_off) {
+		return SBI_ENOMEM;
+	}
+
+	sbi_emulate_csr_counters_update(scratch);
+
+	return 0;
+}
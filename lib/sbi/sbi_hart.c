@@ -15,11 +15,14 @@
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_domain.h>
 #include <sbi/sbi_csr_detect.h>
+#include <sbi/sbi_emulate_csr.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_hart.h>
+#include <sbi/sbi_latency.h>
 #include <sbi/sbi_math.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_pmu.h>
+#include <sbi/sbi_profile.h>
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_trap.h>
 #include <sbi/sbi_hfence.h>
@@ -61,6 +64,7 @@ static void mstatus_init(struct sbi_scratch *scratch)
 	 */
 	if (sbi_hart_priv_version(scratch) >= SBI_HART_PRIV_VER_1_10)
 		csr_write(CSR_MCOUNTEREN, -1);
+	sbi_emulate_csr_counters_update(scratch);
 
 	/* All programmable counters will start running at runtime after S-mode request */
 	if (sbi_hart_priv_version(scratch) >= SBI_HART_PRIV_VER_1_11)
@@ -715,6 +719,8 @@ const struct sbi_hart_ext_data sbi_hart_ext[] = {
 	__SBI_HART_EXT_DATA(smctr, SBI_HART_EXT_SMCTR),
 	__SBI_HART_EXT_DATA(ssctr, SBI_HART_EXT_SSCTR),
 	__SBI_HART_EXT_DATA(ssstateen, SBI_HART_EXT_SSSTATEEN),
+	__SBI_HART_EXT_DATA(svinval, SBI_HART_EXT_SVINVAL),
+	__SBI_HART_EXT_DATA(zawrs, SBI_HART_EXT_ZAWRS),
 };
 
 _Static_assert(SBI_HART_EXT_MAX == array_size(sbi_hart_ext),
@@ -983,6 +989,21 @@ __pmp_skip:
 
 #undef __check_ext_csr
 
+	/* Detect if hart supports Svinval by executing SFENCE.W.INVAL */
+	insn_exec_allowed(INSN_MATCH_SFENCE_W_INVAL, &trap);
+	if (!trap.cause)
+		__sbi_hart_update_extension(hfeatures,
+					    SBI_HART_EXT_SVINVAL, true);
+
+	/*
+	 * Detect if hart supports Zawrs by executing WRS.STO which
+	 * returns right away as no reservation set is registered.
+	 */
+	insn_exec_allowed(INSN_MATCH_WRS_STO, &trap);
+	if (!trap.cause)
+		__sbi_hart_update_extension(hfeatures,
+					    SBI_HART_EXT_ZAWRS, true);
+
 #define __check_csr_existence(__csr, __csr_id)				\
 	csr_read_allowed(__csr, &trap);					\
 	if (!trap.cause)						\
@@ -1071,8 +1092,54 @@ int sbi_hart_init(struct sbi_scratch *scratch, bool cold_boot)
 	return sbi_hart_reinit(scratch);
 }
 
+/* Polling iterations of sbi_hart_wait_value() without Zawrs */
+#define HART_WAIT_SPINS		64
+
+/**
+ * Wait for a word in memory to change from the given value.
+ *
+ * With Zawrs, the word is registered as the reservation set and the hart
+ * stalls in WRS.STO until the word is written, an interrupt is pending or
+ * a short timeout expires. Otherwise the word is polled a bounded number
+ * of times with cpu_relax() in between. WFI is not used because neither
+ * acknowledgements nor M-mode timeouts raise an interrupt here.
+ *
+ * The wait is bounded and may return early, so callers must re-check
+ * their condition in a loop.
+ */
+void sbi_hart_wait_value(const volatile long *addr, long val)
+{
+	struct sbi_profile_window win;
+	long cur;
+	int i;
+
+	sbi_profile_enter(&win);
+
+	if (sbi_hart_has_extension(sbi_scratch_thishart_ptr(),
+				   SBI_HART_EXT_ZAWRS)) {
+		__asm__ __volatile__(
+#if __riscv_xlen == 64
+			"lr.d	%0, (%1)"
+#else
+			"lr.w	%0, (%1)"
+#endif
+			: "=&r"(cur) : "r"(addr) : "memory");
+		if (cur == val)
+			__asm__ __volatile__(".word %[wrs_sto]"
+					     : : [wrs_sto] "i" (INSN_MATCH_WRS_STO)
+					     : "memory");
+	} else {
+		for (i = 0; i < HART_WAIT_SPINS && *addr == val; i++)
+			cpu_relax();
+	}
+
+	sbi_profile_exit(&win);
+}
+
 void __attribute__((noreturn)) sbi_hart_hang(void)
 {
+	sbi_latency_dump(current_hartindex());
+
 	while (1)
 		wfi();
 	__builtin_unreachable();
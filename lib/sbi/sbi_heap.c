@@ -18,12 +18,29 @@
 #define HEAP_ALLOC_ALIGN		64
 #define HEAP_HOUSEKEEPING_FACTOR	16
 
+/* Slab caches serve allocations of 64, 128, 256 and 512 bytes */
+#define HEAP_SLAB_CLASSES		4
+#define HEAP_SLAB_MAX_SIZE		(HEAP_ALLOC_ALIGN << (HEAP_SLAB_CLASSES - 1))
+#define HEAP_SLAB_PAGE_SIZE		2048
+
 struct heap_node {
 	struct sbi_dlist head;
 	unsigned long addr;
 	unsigned long size;
 };
 
+/* Slab page carved into objects of one size class */
+struct heap_slab {
+	/* Node in the partial list of the size class */
+	struct sbi_dlist head;
+	/* Singly linked list of free objects */
+	void *free;
+	/* Number of allocated objects */
+	unsigned long inuse;
+	/* Size class index */
+	unsigned long cls;
+};
+
 struct sbi_heap_control {
 	spinlock_t lock;
 	unsigned long base;
@@ -33,6 +50,15 @@ struct sbi_heap_control {
 	struct sbi_dlist free_node_list;
 	struct sbi_dlist free_space_list;
 	struct sbi_dlist used_space_list;
+#ifdef CONFIG_SBI_HEAP_SLAB
+	spinlock_t slab_lock;
+	/* Slab of each HEAP_SLAB_PAGE_SIZE page of the heap (or NULL) */
+	struct heap_slab **slab_pages;
+	unsigned long slab_base;
+	unsigned long slab_count;
+	/* Slabs with free objects of each size class */
+	struct sbi_dlist slab_partial[HEAP_SLAB_CLASSES];
+#endif
 };
 
 struct sbi_heap_control global_hpctrl;
@@ -122,14 +148,188 @@ out:
 	return ret;
 }
 
+static void free_from_heap(struct sbi_heap_control *hpctrl, void *ptr);
+
+#ifdef CONFIG_SBI_HEAP_SLAB
+static inline struct heap_slab **slab_page_slot(struct sbi_heap_control *hpctrl,
+						 unsigned long addr)
+{
+	if (!hpctrl->slab_pages || addr < hpctrl->slab_base ||
+	    (addr - hpctrl->slab_base) / HEAP_SLAB_PAGE_SIZE >=
+	    hpctrl->slab_count)
+		return NULL;
+
+	return &hpctrl->slab_pages[(addr - hpctrl->slab_base) /
+				   HEAP_SLAB_PAGE_SIZE];
+}
+
+static struct heap_slab *slab_new(struct sbi_heap_control *hpctrl,
+				  unsigned long cls)
+{
+	unsigned long obj_size = HEAP_ALLOC_ALIGN << cls, i;
+	struct heap_slab *s;
+	char *page;
+
+	page = alloc_with_align(hpctrl, HEAP_SLAB_PAGE_SIZE,
+				HEAP_SLAB_PAGE_SIZE);
+	if (!page)
+		return NULL;
+	s = alloc_with_align(hpctrl, HEAP_ALLOC_ALIGN, sizeof(*s));
+	if (!s) {
+		free_from_heap(hpctrl, page);
+		return NULL;
+	}
+
+	SBI_INIT_LIST_HEAD(&s->head);
+	s->inuse = 0;
+	s->cls = cls;
+	s->free = NULL;
+	for (i = HEAP_SLAB_PAGE_SIZE; i >= obj_size; i -= obj_size) {
+		*(void **)(page + i - obj_size) = s->free;
+		s->free = page + i - obj_size;
+	}
+
+	return s;
+}
+
+/*
+ * Allocate from the slab cache of the smallest size class fitting both
+ * size and alignment. Objects are naturally aligned to their size since
+ * slab pages are aligned to HEAP_SLAB_PAGE_SIZE.
+ */
+static void *slab_alloc(struct sbi_heap_control *hpctrl, size_t align,
+			size_t size)
+{
+	unsigned long cls = 0, page;
+	struct heap_slab *s, *ns;
+	void *obj;
+
+	if (!hpctrl->slab_pages || !size || size > HEAP_SLAB_MAX_SIZE ||
+	    align > HEAP_SLAB_MAX_SIZE)
+		return NULL;
+	while ((HEAP_ALLOC_ALIGN << cls) < size ||
+	       (HEAP_ALLOC_ALIGN << cls) < align)
+		cls++;
+
+	spin_lock(&hpctrl->slab_lock);
+
+	if (sbi_list_empty(&hpctrl->slab_partial[cls])) {
+		/* The backing heap has its own lock */
+		spin_unlock(&hpctrl->slab_lock);
+		ns = slab_new(hpctrl, cls);
+		if (!ns)
+			return NULL;
+		spin_lock(&hpctrl->slab_lock);
+
+		page = ROUNDDOWN((unsigned long)ns->free, HEAP_SLAB_PAGE_SIZE);
+		*slab_page_slot(hpctrl, page) = ns;
+		sbi_list_add(&ns->head, &hpctrl->slab_partial[cls]);
+	}
+
+	s = sbi_list_first_entry(&hpctrl->slab_partial[cls],
+				 struct heap_slab, head);
+	obj = s->free;
+	s->free = *(void **)obj;
+	s->inuse++;
+	if (!s->free)
+		sbi_list_del_init(&s->head);
+
+	spin_unlock(&hpctrl->slab_lock);
+
+	return obj;
+}
+
+static bool slab_free(struct sbi_heap_control *hpctrl, void *ptr)
+{
+	unsigned long page = ROUNDDOWN((unsigned long)ptr, HEAP_SLAB_PAGE_SIZE);
+	struct heap_slab **slot, *s, *release = NULL;
+	struct sbi_dlist *partial;
+
+	slot = slab_page_slot(hpctrl, page);
+	if (!slot)
+		return false;
+
+	spin_lock(&hpctrl->slab_lock);
+
+	s = *slot;
+	if (!s) {
+		spin_unlock(&hpctrl->slab_lock);
+		return false;
+	}
+
+	partial = &hpctrl->slab_partial[s->cls];
+	if (!s->free)
+		sbi_list_add(&s->head, partial);
+	*(void **)ptr = s->free;
+	s->free = ptr;
+	s->inuse--;
+
+	/* Give empty slabs back but keep one per class to avoid thrashing */
+	if (!s->inuse && partial->next != partial->prev) {
+		sbi_list_del(&s->head);
+		*slot = NULL;
+		release = s;
+	}
+
+	spin_unlock(&hpctrl->slab_lock);
+
+	if (release) {
+		free_from_heap(hpctrl, (void *)page);
+		free_from_heap(hpctrl, release);
+	}
+
+	return true;
+}
+
+static void slab_init(struct sbi_heap_control *hpctrl)
+{
+	unsigned long i, end = hpctrl->base + hpctrl->size;
+
+	SPIN_LOCK_INIT(hpctrl->slab_lock);
+	for (i = 0; i < HEAP_SLAB_CLASSES; i++)
+		SBI_INIT_LIST_HEAD(&hpctrl->slab_partial[i]);
+
+	hpctrl->slab_base = ROUNDDOWN(hpctrl->base, HEAP_SLAB_PAGE_SIZE);
+	hpctrl->slab_count = (ROUNDUP(end, HEAP_SLAB_PAGE_SIZE) -
+			      hpctrl->slab_base) / HEAP_SLAB_PAGE_SIZE;
+
+	/* Without the page table all allocations use the backing heap */
+	hpctrl->slab_pages = alloc_with_align(hpctrl, HEAP_ALLOC_ALIGN,
+			hpctrl->slab_count * sizeof(*hpctrl->slab_pages));
+	if (hpctrl->slab_pages)
+		sbi_memset(hpctrl->slab_pages, 0,
+			   hpctrl->slab_count * sizeof(*hpctrl->slab_pages));
+}
+#else
+static inline void *slab_alloc(struct sbi_heap_control *hpctrl,
+			       size_t align, size_t size)
+{
+	return NULL;
+}
+
+static inline bool slab_free(struct sbi_heap_control *hpctrl, void *ptr)
+{
+	return false;
+}
+
+static inline void slab_init(struct sbi_heap_control *hpctrl) { }
+#endif
+
 void *sbi_malloc_from(struct sbi_heap_control *hpctrl, size_t size)
 {
+	void *ret = slab_alloc(hpctrl, HEAP_ALLOC_ALIGN, size);
+
+	if (ret)
+		return ret;
+
 	return alloc_with_align(hpctrl, HEAP_ALLOC_ALIGN, size);
 }
 
 void *sbi_aligned_alloc_from(struct sbi_heap_control *hpctrl,
 			     size_t alignment, size_t size)
 {
+	void *ret;
+
 	if (alignment < HEAP_ALLOC_ALIGN)
 		alignment = HEAP_ALLOC_ALIGN;
 
@@ -141,6 +341,10 @@ void *sbi_aligned_alloc_from(struct sbi_heap_control *hpctrl,
 	if (size % alignment != 0)
 		return NULL;
 
+	ret = slab_alloc(hpctrl, alignment, size);
+	if (ret)
+		return ret;
+
 	return alloc_with_align(hpctrl, alignment, size);
 }
 
@@ -153,13 +357,10 @@ void *sbi_zalloc_from(struct sbi_heap_control *hpctrl, size_t size)
 	return ret;
 }
 
-void sbi_free_from(struct sbi_heap_control *hpctrl, void *ptr)
+static void free_from_heap(struct sbi_heap_control *hpctrl, void *ptr)
 {
 	struct heap_node *n, *np;
 
-	if (!ptr)
-		return;
-
 	spin_lock(&hpctrl->lock);
 
 	np = NULL;
@@ -201,6 +402,15 @@ void sbi_free_from(struct sbi_heap_control *hpctrl, void *ptr)
 	spin_unlock(&hpctrl->lock);
 }
 
+void sbi_free_from(struct sbi_heap_control *hpctrl, void *ptr)
+{
+	if (!ptr)
+		return;
+
+	if (!slab_free(hpctrl, ptr))
+		free_from_heap(hpctrl, ptr);
+}
+
 unsigned long sbi_heap_free_space_from(struct sbi_heap_control *hpctrl)
 {
 	struct heap_node *n;
@@ -256,6 +466,8 @@ int sbi_heap_init_new(struct sbi_heap_control *hpctrl, unsigned long base,
 	n->size = hpctrl->size - hpctrl->hksize;
 	sbi_list_add_tail(&n->head, &hpctrl->free_space_list);
 
+	slab_init(hpctrl);
+
 	return 0;
 }
 
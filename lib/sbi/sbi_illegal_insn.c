@@ -15,6 +15,7 @@
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_illegal_atomic.h>
 #include <sbi/sbi_illegal_insn.h>
+#include <sbi/sbi_latency.h>
 #include <sbi/sbi_pmu.h>
 #include <sbi/sbi_trap.h>
 #include <sbi/sbi_unpriv.h>
@@ -110,6 +111,25 @@ static int system_opcode_insn(ulong insn, struct sbi_trap_regs *regs)
 	return 0;
 }
 
+/*
+ * Trapped rdtime is by far the most frequent illegal instruction on
+ * HARTs without a time CSR, so it skips the generic CSR instruction
+ * decode. Anything unusual is left to system_opcode_insn().
+ */
+static int rdtime_insn(ulong insn, struct sbi_trap_regs *regs)
+{
+	ulong csr_val;
+
+	if (sbi_mstatus_prev_mode(regs->mstatus) == PRV_M ||
+	    sbi_emulate_csr_read(GET_CSR_NUM((u32)insn), regs, &csr_val))
+		return system_opcode_insn(insn, regs);
+
+	SET_RD(insn, regs, csr_val);
+	regs->mepc += 4;
+
+	return 0;
+}
+
 static const illegal_insn_func illegal_insn_table[32] = {
 	truly_illegal_insn, /* 0 */
 	truly_illegal_insn, /* 1 */
@@ -171,5 +191,10 @@ int sbi_illegal_insn_handler(struct sbi_trap_context *tcntx)
 			return truly_illegal_insn(insn, regs);
 	}
 
+	sbi_latency_note_illegal(insn);
+	if ((insn & INSN_MASK_RDTIME) == INSN_MATCH_RDTIME ||
+	    (insn & INSN_MASK_RDTIME) == INSN_MATCH_RDTIMEH)
+		return rdtime_insn(insn, regs);
+
 	return illegal_insn_table[(insn & 0x7c) >> 2](insn, regs);
 }
@@ -10,11 +10,13 @@
 #include <sbi/riscv_asm.h>
 #include <sbi/riscv_atomic.h>
 #include <sbi/riscv_barrier.h>
+#include <sbi/sbi_batch.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_cppc.h>
 #include <sbi/sbi_domain.h>
 #include <sbi/sbi_double_trap.h>
 #include <sbi/sbi_ecall.h>
+#include <sbi/sbi_emulate_csr.h>
 #include <sbi/sbi_fwft.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_hartmask.h>
@@ -22,8 +24,10 @@
 #include <sbi/sbi_hsm.h>
 #include <sbi/sbi_ipi.h>
 #include <sbi/sbi_irqchip.h>
+#include <sbi/sbi_latency.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_pmu.h>
+#include <sbi/sbi_profile.h>
 #include <sbi/sbi_dbtr.h>
 #include <sbi/sbi_mpxy.h>
 #include <sbi/sbi_sse.h>
@@ -267,6 +271,13 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 	if (rc)
 		sbi_hart_hang();
 
+	rc = sbi_emulate_csr_init(scratch, true);
+	if (rc) {
+		sbi_printf("%s: csr emulation init failed (error %d)\n",
+			   __func__, rc);
+		sbi_hart_hang();
+	}
+
 	rc = sbi_pmu_init(scratch, true);
 	if (rc) {
 		sbi_printf("%s: pmu init failed (error %d)\n",
@@ -274,6 +285,20 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 		sbi_hart_hang();
 	}
 
+	rc = sbi_latency_init(scratch, true);
+	if (rc) {
+		sbi_printf("%s: latency init failed (error %d)\n",
+			   __func__, rc);
+		sbi_hart_hang();
+	}
+
+	rc = sbi_batch_init(scratch, true);
+	if (rc) {
+		sbi_printf("%s: batch init failed (error %d)\n",
+			   __func__, rc);
+		sbi_hart_hang();
+	}
+
 	rc = sbi_dbtr_init(scratch, true);
 	if (rc)
 		sbi_hart_hang();
@@ -307,6 +332,13 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 		sbi_hart_hang();
 	}
 
+	rc = sbi_profile_init(scratch, true);
+	if (rc) {
+		sbi_printf("%s: profile init failed (error %d)\n",
+			   __func__, rc);
+		sbi_hart_hang();
+	}
+
 	rc = sbi_fwft_init(scratch, true);
 	if (rc) {
 		sbi_printf("%s: fwft init failed (error %d)\n", __func__, rc);
@@ -426,10 +458,22 @@ static void __noreturn init_warm_startup(struct sbi_scratch *scratch,
 	if (rc)
 		sbi_hart_hang();
 
+	rc = sbi_emulate_csr_init(scratch, false);
+	if (rc)
+		sbi_hart_hang();
+
 	rc = sbi_pmu_init(scratch, false);
 	if (rc)
 		sbi_hart_hang();
 
+	rc = sbi_latency_init(scratch, false);
+	if (rc)
+		sbi_hart_hang();
+
+	rc = sbi_batch_init(scratch, false);
+	if (rc)
+		sbi_hart_hang();
+
 	rc = sbi_dbtr_init(scratch, false);
 	if (rc)
 		sbi_hart_hang();
@@ -450,6 +494,10 @@ static void __noreturn init_warm_startup(struct sbi_scratch *scratch,
 	if (rc)
 		sbi_hart_hang();
 
+	rc = sbi_profile_init(scratch, false);
+	if (rc)
+		sbi_hart_hang();
+
 	rc = sbi_fwft_init(scratch, false);
 	if (rc)
 		sbi_hart_hang();
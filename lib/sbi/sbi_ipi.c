@@ -36,8 +36,13 @@ static unsigned long ipi_data_off;
 static const struct sbi_ipi_device *ipi_dev = NULL;
 static const struct sbi_ipi_event_ops *ipi_ops_array[SBI_IPI_EVENT_MAX];
 
+/**
+ * Prepare and trigger an IPI event for one remote HART. When a batch mask
+ * is passed, the HART index is added to it instead of raising the IPI so
+ * that the caller can raise all IPIs in one sbi_ipi_raw_send_many() call.
+ */
 static int sbi_ipi_send(struct sbi_scratch *scratch, u32 remote_hartindex,
-			u32 event, void *data)
+			u32 event, void *data, struct sbi_hartmask *batch)
 {
 	int ret = 0;
 	struct sbi_scratch *remote_scratch = NULL;
@@ -79,8 +84,12 @@ static int sbi_ipi_send(struct sbi_scratch *scratch, u32 remote_hartindex,
 	 * the ipi_type was previously zero.
 	 */
 	if (!__atomic_fetch_or(&ipi_data->ipi_type,
-				BIT(event), __ATOMIC_RELAXED))
-		ret = sbi_ipi_raw_send(remote_hartindex);
+				BIT(event), __ATOMIC_RELAXED)) {
+		if (batch)
+			sbi_hartmask_set_hartindex(remote_hartindex, batch);
+		else
+			ret = sbi_ipi_raw_send(remote_hartindex);
+	}
 
 	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_IPI_SENT);
 
@@ -110,9 +119,9 @@ static int sbi_ipi_sync(struct sbi_scratch *scratch, u32 event)
 int sbi_ipi_send_many(ulong hmask, ulong hbase, u32 event, void *data)
 {
 	int rc = 0;
-	bool retry_needed;
+	bool retry_needed, use_batch;
 	ulong i;
-	struct sbi_hartmask target_mask;
+	struct sbi_hartmask target_mask, batch_mask;
 	struct sbi_domain *dom = sbi_domain_thishart_ptr();
 	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
 
@@ -141,19 +150,34 @@ int sbi_ipi_send_many(ulong hmask, ulong hbase, u32 event, void *data)
 			return SBI_EINVAL;
 	}
 
+	/*
+	 * Raise the IPIs of each pass with a single device call when the
+	 * device supports it and there is more than one target. Each pass
+	 * is flushed before retrying because a target has to take its IPI
+	 * to make room for the retried update.
+	 */
+	use_batch = ipi_dev && ipi_dev->ipi_send_many &&
+		    sbi_hartmask_weight(&target_mask) > 1;
+
 	/* Send IPIs */
 	do {
 		retry_needed = false;
+		sbi_hartmask_clear_all(&batch_mask);
 		sbi_hartmask_for_each_hartindex(i, &target_mask) {
-			rc = sbi_ipi_send(scratch, i, event, data);
+			rc = sbi_ipi_send(scratch, i, event, data,
+					  use_batch ? &batch_mask : NULL);
 			if (rc < 0)
-				goto done;
+				break;
 			if (rc == SBI_IPI_UPDATE_RETRY)
 				retry_needed = true;
 			else
 				sbi_hartmask_clear_hartindex(i, &target_mask);
 			rc = 0;
 		}
+		if (use_batch)
+			sbi_ipi_raw_send_many(&batch_mask);
+		if (rc < 0)
+			goto done;
 	} while (retry_needed);
 
 done:
@@ -163,6 +187,39 @@ done:
 	return rc;
 }
 
+/**
+ * Raise an IPI event on the given HARTs without calling the update() and
+ * sync() callbacks of the event. This is meant for relaying an event on
+ * behalf of another HART which has already done the update, so the mask
+ * is trusted to only contain interruptible HARTs.
+ */
+int sbi_ipi_event_raise(const struct sbi_hartmask *mask, u32 event)
+{
+	u32 i;
+	struct sbi_scratch *remote_scratch;
+	struct sbi_ipi_data *ipi_data;
+	struct sbi_hartmask batch_mask;
+
+	if (!mask || (SBI_IPI_EVENT_MAX <= event) || !ipi_ops_array[event])
+		return SBI_EINVAL;
+
+	sbi_hartmask_clear_all(&batch_mask);
+	sbi_hartmask_for_each_hartindex(i, mask) {
+		remote_scratch = sbi_hartindex_to_scratch(i);
+		if (!remote_scratch)
+			continue;
+
+		ipi_data = sbi_scratch_offset_ptr(remote_scratch, ipi_data_off);
+		if (!__atomic_fetch_or(&ipi_data->ipi_type,
+					BIT(event), __ATOMIC_RELAXED))
+			sbi_hartmask_set_hartindex(i, &batch_mask);
+
+		sbi_pmu_ctr_incr_fw(SBI_PMU_FW_IPI_SENT);
+	}
+
+	return sbi_ipi_raw_send_many(&batch_mask);
+}
+
 int sbi_ipi_event_create(const struct sbi_ipi_event_ops *ops)
 {
 	int i, ret = SBI_ENOSPC;
@@ -283,6 +340,34 @@ int sbi_ipi_raw_send(u32 hartindex)
 	return 0;
 }
 
+int sbi_ipi_raw_send_many(const struct sbi_hartmask *mask)
+{
+	u32 i;
+
+	if (!ipi_dev || !mask)
+		return SBI_EINVAL;
+
+	if (!ipi_dev->ipi_send_many) {
+		sbi_hartmask_for_each_hartindex(i, mask)
+			sbi_ipi_raw_send(i);
+		return 0;
+	}
+
+	if (sbi_hartmask_weight(mask) == 0)
+		return 0;
+
+	/*
+	 * One barrier covers the whole burst of relaxed MMIO writes
+	 * done by the ipi_send_many() device callback.
+	 *
+	 * This pairs with the wmb() in sbi_ipi_raw_clear().
+	 */
+	wmb();
+
+	ipi_dev->ipi_send_many(mask);
+	return 0;
+}
+
 void sbi_ipi_raw_clear(void)
 {
 	if (ipi_dev && ipi_dev->ipi_clear)
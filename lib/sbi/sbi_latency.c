@@ -0,0 +1,234 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 Sophgo Technology Inc.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_encoding.h>
+#include <sbi/sbi_bitops.h>
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_latency.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+
+struct latency_hart {
+	struct sbi_latency_stats stats;
+	/** Major opcode + 1 of the illegal instruction being handled */
+	unsigned long pending_illegal;
+	/** The trap being handled was redirected to S/U-mode */
+	bool pending_redirect;
+};
+
+static unsigned long latency_ptr_off;
+
+#define latency_get_hart(__scratch)					\
+	sbi_scratch_read_type((__scratch), void *, latency_ptr_off)
+
+#define latency_set_hart(__scratch, __lh)				\
+	sbi_scratch_write_type((__scratch), void *, latency_ptr_off, (__lh))
+
+static inline struct latency_hart *latency_thishart(void)
+{
+	if (!latency_ptr_off)
+		return NULL;
+
+	return latency_get_hart(sbi_scratch_thishart_ptr());
+}
+
+static inline void latency_hist_add(struct sbi_latency_hist *hist,
+				    unsigned long cycles)
+{
+	unsigned long bucket = 0;
+
+	if (cycles >= 64)
+		bucket = MIN((sbi_fls(cycles) - 4) / 2,
+			     (unsigned long)SBI_LATENCY_BUCKETS - 1);
+
+	hist->count[bucket]++;
+	hist->cycles += cycles;
+	if (hist->max < cycles)
+		hist->max = cycles;
+}
+
+/*
+ * Only the HART owning the histograms updates them, so no locking is
+ * needed. Snapshots taken from another HART may be slightly stale.
+ */
+void sbi_latency_ecall_record(unsigned long extid, unsigned long funcid,
+			      unsigned long start)
+{
+	unsigned long cycles = csr_read(CSR_MCYCLE) - start;
+	struct latency_hart *lh = latency_thishart();
+	struct sbi_latency_stats *stats;
+	struct sbi_latency_ecall_hist *e;
+	u32 i, slot;
+
+	if (!lh)
+		return;
+	stats = &lh->stats;
+
+	slot = ((u32)extid ^ ((u32)funcid * 0x9e3779b1U)) %
+		SBI_LATENCY_ECALL_SLOTS;
+	for (i = 0; i < SBI_LATENCY_ECALL_SLOTS; i++) {
+		e = &stats->ecall[(slot + i) % SBI_LATENCY_ECALL_SLOTS];
+		if (e->extid == -1U) {
+			e->extid = extid;
+			e->funcid = funcid;
+		}
+		if (e->extid == (u32)extid && e->funcid == (u32)funcid) {
+			latency_hist_add(&e->hist, cycles);
+			return;
+		}
+	}
+
+	latency_hist_add(&stats->ecall_other, cycles);
+}
+
+void sbi_latency_note_illegal(unsigned long insn)
+{
+	struct latency_hart *lh = latency_thishart();
+
+	if (lh)
+		lh->pending_illegal = ((insn & 0x7c) >> 2) + 1;
+}
+
+void sbi_latency_note_redirect(void)
+{
+	struct latency_hart *lh = latency_thishart();
+
+	if (lh)
+		lh->pending_redirect = true;
+}
+
+/*
+ * Record a trap by cause and, if noted while handling it, by illegal
+ * instruction opcode and as redirected, all with the same latency.
+ */
+void sbi_latency_trap_record(unsigned long mcause, unsigned long start)
+{
+	unsigned long cycles = csr_read(CSR_MCYCLE) - start;
+	unsigned long code = mcause & ~MCAUSE_IRQ_MASK;
+	struct latency_hart *lh = latency_thishart();
+	struct sbi_latency_stats *stats;
+
+	if (!lh)
+		return;
+	stats = &lh->stats;
+
+	if (mcause & MCAUSE_IRQ_MASK) {
+		if (code < SBI_LATENCY_IRQ_CAUSES)
+			latency_hist_add(&stats->irq[code], cycles);
+		else
+			latency_hist_add(&stats->trap_other, cycles);
+	} else {
+		if (code < SBI_LATENCY_EXC_CAUSES)
+			latency_hist_add(&stats->exc[code], cycles);
+		else
+			latency_hist_add(&stats->trap_other, cycles);
+	}
+
+	if (lh->pending_illegal) {
+		latency_hist_add(&stats->illegal[lh->pending_illegal - 1],
+				 cycles);
+		lh->pending_illegal = 0;
+	}
+	if (lh->pending_redirect) {
+		latency_hist_add(&stats->redirect, cycles);
+		lh->pending_redirect = false;
+	}
+}
+
+const struct sbi_latency_stats *sbi_latency_get_stats(u32 hartindex)
+{
+	struct sbi_scratch *scratch = sbi_hartindex_to_scratch(hartindex);
+	struct latency_hart *lh;
+
+	if (!scratch || !latency_ptr_off)
+		return NULL;
+
+	lh = latency_get_hart(scratch);
+	return lh ? &lh->stats : NULL;
+}
+
+static void latency_print(u32 hartid, const char *kind, u32 idx,
+			  const struct sbi_latency_hist *hist)
+{
+	unsigned long long count = 0;
+	u32 i;
+
+	for (i = 0; i < SBI_LATENCY_BUCKETS; i++)
+		count += hist->count[i];
+	if (!count)
+		return;
+
+	sbi_printf("LAT %u %s 0x%x: count %llu avg %llu max %llu cycles\n",
+		   hartid, kind, idx, count,
+		   (unsigned long long)(hist->cycles / count),
+		   (unsigned long long)hist->max);
+}
+
+/** Print the non-empty latency histograms of a HART on the console */
+void sbi_latency_dump(u32 hartindex)
+{
+	const struct sbi_latency_stats *stats = sbi_latency_get_stats(hartindex);
+	u32 i, hartid = sbi_hartindex_to_hartid(hartindex);
+
+	if (!stats)
+		return;
+
+	for (i = 0; i < SBI_LATENCY_ECALL_SLOTS; i++) {
+		if (stats->ecall[i].extid == -1U)
+			continue;
+		sbi_printf("LAT %u ecall 0x%x func 0x%x\n", hartid,
+			   stats->ecall[i].extid, stats->ecall[i].funcid);
+		latency_print(hartid, "ecall-slot", i, &stats->ecall[i].hist);
+	}
+	latency_print(hartid, "ecall-other", 0, &stats->ecall_other);
+	for (i = 0; i < SBI_LATENCY_EXC_CAUSES; i++)
+		latency_print(hartid, "exc", i, &stats->exc[i]);
+	for (i = 0; i < SBI_LATENCY_IRQ_CAUSES; i++)
+		latency_print(hartid, "irq", i, &stats->irq[i]);
+	latency_print(hartid, "trap-other", 0, &stats->trap_other);
+	for (i = 0; i < SBI_LATENCY_ILLEGAL_OPS; i++)
+		latency_print(hartid, "illegal-op", i, &stats->illegal[i]);
+	latency_print(hartid, "redirect", 0, &stats->redirect);
+}
+
+void sbi_latency_dump_all(void)
+{
+	sbi_for_each_hartindex(i)
+		sbi_latency_dump(i);
+}
+
+int sbi_latency_init(struct sbi_scratch *scratch, bool cold_boot)
+{
+	struct latency_hart *lh;
+	u32 i;
+
+	if (cold_boot) {
+		latency_ptr_off = sbi_scratch_alloc_type_offset(void *);
+		if (!latency_ptr_off)
+			return SBI_ENOMEM;
+	} else if (!latency_ptr_off) {
+		return SBI_ENOMEM;
+	}
+
+	lh = latency_get_hart(scratch);
+	if (!lh) {
+		lh = sbi_zalloc(sizeof(*lh));
+		if (!lh)
+			return SBI_ENOMEM;
+		latency_set_hart(scratch, lh);
+	} else {
+		sbi_memset(lh, 0, sizeof(*lh));
+	}
+
+	for (i = 0; i < SBI_LATENCY_ECALL_SLOTS; i++)
+		lh->stats.ecall[i].extid = -1U;
+
+	return 0;
+}
@@ -0,0 +1,188 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 Sophgo Technology Inc.
+ */
+
+#include <sbi/riscv_atomic.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_fifo.h>
+#include <sbi/sbi_hart.h>
+#include <sbi/sbi_mpsc_fifo.h>
+#include <sbi/sbi_string.h>
+
+#define MPSC_SEQ_BUSY		(-1L)
+
+static inline void *mpsc_entry(struct sbi_mpsc_fifo *fifo, unsigned long pos)
+{
+	return (char *)fifo->queue +
+		(size_t)(pos % fifo->num_entries) * fifo->entry_size;
+}
+
+static inline atomic_t *mpsc_seq(struct sbi_mpsc_fifo *fifo, unsigned long pos)
+{
+	return &fifo->seq[pos % fifo->num_entries];
+}
+
+static inline void mpsc_seq_release(atomic_t *seq, long val)
+{
+	__smp_store_release(&seq->counter, val);
+}
+
+void sbi_mpsc_fifo_init(struct sbi_mpsc_fifo *fifo, void *mem, u16 entries,
+			u16 entry_size)
+{
+	u16 i;
+
+	fifo->seq	  = mem;
+	fifo->queue	  = (char *)mem + (size_t)entries * sizeof(atomic_t);
+	fifo->num_entries = entries;
+	fifo->entry_size  = entry_size;
+	fifo->tail	  = 0;
+	ATOMIC_INIT(&fifo->head, 0);
+	sbi_memset(fifo->queue, 0, (size_t)entries * entry_size);
+	for (i = 0; i < entries; i++)
+		ATOMIC_INIT(&fifo->seq[i], i);
+	smp_wmb();
+}
+
+bool sbi_mpsc_fifo_is_empty(struct sbi_mpsc_fifo *fifo)
+{
+	if (!fifo)
+		return true;
+
+	return (unsigned long)atomic_read(&fifo->head) == fifo->tail;
+}
+
+/**
+ * Enqueue an entry from any HART.
+ *
+ * The slot is reserved by moving the head forward with a compare-and-swap,
+ * filled without any lock held and then published by releasing the slot
+ * sequence number to the consumer.
+ */
+int sbi_mpsc_fifo_enqueue(struct sbi_mpsc_fifo *fifo, void *data)
+{
+	unsigned long pos;
+	atomic_t *seq;
+	long diff;
+
+	if (!fifo || !data)
+		return SBI_EINVAL;
+
+	pos = atomic_read(&fifo->head);
+	while (1) {
+		seq = mpsc_seq(fifo, pos);
+		diff = __smp_load_acquire(&seq->counter) - (long)pos;
+		if (diff == 0) {
+			if (atomic_cmpxchg(&fifo->head, pos, pos + 1) == pos)
+				break;
+		} else if (diff < 0) {
+			/* Slot still holds an entry from the previous lap */
+			return SBI_ENOSPC;
+		}
+		pos = atomic_read(&fifo->head);
+	}
+
+	sbi_memcpy(mpsc_entry(fifo, pos), data, fifo->entry_size);
+	mpsc_seq_release(seq, pos + 1);
+
+	return 0;
+}
+
+/**
+ * Dequeue an entry. Must only be called by the HART owning the FIFO.
+ *
+ * A published slot is claimed with a compare-and-swap so that a producer
+ * doing an in-place update of the same slot is never observed half way.
+ */
+int sbi_mpsc_fifo_dequeue(struct sbi_mpsc_fifo *fifo, void *data)
+{
+	unsigned long pos;
+	atomic_t *seq;
+	long cur;
+
+	if (!fifo || !data)
+		return SBI_EINVAL;
+
+	pos = fifo->tail;
+	seq = mpsc_seq(fifo, pos);
+	while (1) {
+		cur = atomic_cmpxchg(seq, pos + 1, MPSC_SEQ_BUSY);
+		if (cur == (long)(pos + 1))
+			break;
+		/* Producer is merging into this slot, wait for it */
+		if (cur == MPSC_SEQ_BUSY) {
+			cpu_relax();
+			continue;
+		}
+		/* Not yet reserved or reserved but not yet published */
+		return SBI_ENOENT;
+	}
+
+	sbi_memcpy(data, mpsc_entry(fifo, pos), fifo->entry_size);
+	fifo->tail = pos + 1;
+	mpsc_seq_release(seq, pos + fifo->num_entries);
+
+	return 0;
+}
+
+/**
+ * Provide a helper function to do inplace update to the fifo from any HART.
+ *
+ * Each published entry is claimed while the callback runs on it, so the
+ * callback may modify the entry. Entries concurrently being dequeued or
+ * updated by another producer are simply not considered.
+ *
+ * **Do not** invoke any other fifo function from callback.
+ */
+int sbi_mpsc_fifo_inplace_update(struct sbi_mpsc_fifo *fifo, void *in,
+				 int (*fptr)(void *in, void *data))
+{
+	int ret = SBI_FIFO_UNCHANGED;
+	unsigned long pos, head;
+	atomic_t *seq;
+
+	if (!fifo || !in)
+		return ret;
+
+	head = atomic_read(&fifo->head);
+	pos = __smp_load_acquire(&fifo->tail);
+	for (; (long)(head - pos) > 0; pos++) {
+		seq = mpsc_seq(fifo, pos);
+		if (atomic_cmpxchg(seq, pos + 1, MPSC_SEQ_BUSY) != (long)(pos + 1))
+			continue;
+
+		ret = fptr(in, mpsc_entry(fifo, pos));
+		mpsc_seq_release(seq, pos + 1);
+
+		if (ret == SBI_FIFO_SKIP || ret == SBI_FIFO_UPDATED)
+			break;
+	}
+
+	return ret;
+}
+
+/**
+ * Wait, without hammering the FIFO, until the slot a producer would take
+ * next is probably free. The wait is bounded so callers must retry the
+ * enqueue and re-check for other work.
+ */
+void sbi_mpsc_fifo_wait_space(struct sbi_mpsc_fifo *fifo)
+{
+	unsigned long pos;
+	atomic_t *seq;
+	long cur;
+
+	if (!fifo)
+		return;
+
+	pos = atomic_read(&fifo->head);
+	seq = mpsc_seq(fifo, pos);
+	cur = __smp_load_acquire(&seq->counter);
+
+	/* Slot still holds an entry from the previous lap */
+	if (cur - (long)pos < 0)
+		sbi_hart_wait_value(&seq->counter, cur);
+}
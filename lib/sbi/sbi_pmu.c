@@ -12,6 +12,7 @@
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_domain.h>
 #include <sbi/sbi_ecall_interface.h>
+#include <sbi/sbi_emulate_csr.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_heap.h>
 #include <sbi/sbi_platform.h>
@@ -19,6 +20,7 @@
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_sse.h>
+#include <sbi/sbi_timer.h>
 
 /** Information about hardware counters */
 struct sbi_pmu_hw_event {
@@ -428,6 +430,27 @@ unsigned long sbi_pmu_irq_mask(void)
 	return BIT(irq_bit);
 }
 
+/*
+ * The set_timer ecall fast path does not count SBI_PMU_FW_SET_TIMER, so
+ * keep it off while a firmware counter of that event is started.
+ */
+static void pmu_fw_set_timer_update(struct sbi_pmu_hart_state *phs)
+{
+#ifdef CONFIG_SBI_ECALL_FAST_TIMER
+	bool counted = false;
+	u32 cidx, code;
+
+	for (cidx = num_hw_ctrs; cidx < total_ctrs; cidx++) {
+		code = get_cidx_code(phs->active_events[cidx]);
+		if (code == SBI_PMU_FW_SET_TIMER &&
+		    (phs->fw_counters_started & BIT(cidx - num_hw_ctrs)))
+			counted = true;
+	}
+
+	sbi_timer_fast_path_allow(!counted);
+#endif
+}
+
 static int pmu_ctr_start_fw(struct sbi_pmu_hart_state *phs,
 			    uint32_t cidx, uint32_t event_code,
 			    uint64_t event_data, uint64_t ival,
@@ -459,6 +482,7 @@ static int pmu_ctr_start_fw(struct sbi_pmu_hart_state *phs,
 	}
 
 	phs->fw_counters_started |= BIT(cidx - num_hw_ctrs);
+	pmu_fw_set_timer_update(phs);
 
 	return 0;
 }
@@ -550,6 +574,7 @@ static int pmu_ctr_stop_fw(struct sbi_pmu_hart_state *phs,
 	}
 
 	phs->fw_counters_started &= ~BIT(cidx - num_hw_ctrs);
+	pmu_fw_set_timer_update(phs);
 
 	return 0;
 }
@@ -904,6 +929,7 @@ skip_match:
 					return ret;
 			}
 			phs->fw_counters_started |= BIT(ctr_idx - num_hw_ctrs);
+			pmu_fw_set_timer_update(phs);
 		}
 	}
 
@@ -1093,6 +1119,7 @@ void sbi_pmu_exit(struct sbi_scratch *scratch)
 
 	if (sbi_hart_priv_version(scratch) >= SBI_HART_PRIV_VER_1_10)
 		csr_write(CSR_MCOUNTEREN, -1);
+	sbi_emulate_csr_counters_update(scratch);
 
 	if (unlikely(!phs))
 		return;
@@ -0,0 +1,248 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 Sophgo Technology Inc.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_platform.h>
+#include <sbi/sbi_profile.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_timer.h>
+#include <sbi/sbi_trap.h>
+
+/*
+ * M-mode normally runs with MSTATUS.MIE clear, so a timer interrupt
+ * cannot land at an arbitrary M-mode PC. Waits and local TLB flushes
+ * open a profiling window in which MIE is set, and only these windows
+ * are sampled: the trap and ecall paths outside of them never are. The
+ * timer event of the profiler traps at the interrupted PC, which is
+ * recorded along with its frame pointer chain. The nested trap only
+ * records the sample and closes the window, the interrupt itself stays
+ * pending and is handled as usual once the HART is back in S-mode.
+ * Closing the window restores the trap CSRs the nested trap clobbered.
+ */
+struct sbi_profile {
+	struct sbi_timer_event ev;
+	u64 sampled;
+	unsigned long head;
+	struct sbi_profile_sample samples[CONFIG_SBI_PROFILER_SAMPLES];
+};
+
+static unsigned long profile_ptr_off;
+
+#define profile_get(__scratch)						\
+	sbi_scratch_read_type((__scratch), void *, profile_ptr_off)
+
+#define profile_set(__scratch, __prof)					\
+	sbi_scratch_write_type((__scratch), void *, profile_ptr_off, (__prof))
+
+static bool profile_fp_valid(struct sbi_scratch *scratch, unsigned long fp)
+{
+	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
+	unsigned long top = (unsigned long)scratch;
+	unsigned long bottom = top + SBI_SCRATCH_SIZE - plat->hart_stack_size;
+
+	/* The saved RA and FP live just below the frame pointer */
+	return !(fp & (sizeof(unsigned long) - 1)) &&
+		bottom + 2 * sizeof(unsigned long) <= fp && fp <= top;
+}
+
+static void profile_timer_fn(struct sbi_timer_event *ev)
+{
+	sbi_timer_add_event(ev, sbi_timer_value() + CONFIG_SBI_PROFILER_PERIOD);
+}
+
+#if __riscv_xlen == 32
+#define PROFILE_MSTATUS_MASK	(MSTATUS_MPP | MSTATUS_MPIE)
+#else
+#define PROFILE_MSTATUS_MASK	(MSTATUS_MPP | MSTATUS_MPIE | MSTATUS_MPV)
+#endif
+
+/**
+ * Open a profiling window
+ *
+ * @param win state to pass to sbi_profile_exit()
+ */
+void sbi_profile_enter(struct sbi_profile_window *win)
+{
+	/*
+	 * Nothing to do in a window already, and an interrupt which is
+	 * already pending would be sampled at the window start.
+	 */
+	win->open = profile_ptr_off &&
+		    !(csr_read(CSR_MSTATUS) & MSTATUS_MIE) &&
+		    !(csr_read(CSR_MIP) & csr_read(CSR_MIE));
+	if (!win->open)
+		return;
+
+	win->mepc = csr_read(CSR_MEPC);
+	win->mcause = csr_read(CSR_MCAUSE);
+	win->mtval = csr_read(CSR_MTVAL);
+	win->mstatus = csr_read(CSR_MSTATUS);
+#if __riscv_xlen == 32
+	if (misa_extension('H'))
+		win->mstatusH = csr_read(CSR_MSTATUSH);
+#endif
+
+	csr_set(CSR_MSTATUS, MSTATUS_MIE);
+}
+
+/**
+ * Close a profiling window opened by sbi_profile_enter()
+ *
+ * @param win state saved by sbi_profile_enter()
+ */
+void sbi_profile_exit(struct sbi_profile_window *win)
+{
+	unsigned long val;
+
+	if (!win->open)
+		return;
+
+	csr_clear(CSR_MSTATUS, MSTATUS_MIE);
+
+	csr_write(CSR_MEPC, win->mepc);
+	csr_write(CSR_MCAUSE, win->mcause);
+	csr_write(CSR_MTVAL, win->mtval);
+	val = csr_read(CSR_MSTATUS) & ~PROFILE_MSTATUS_MASK;
+	csr_write(CSR_MSTATUS, val | (win->mstatus & PROFILE_MSTATUS_MASK));
+#if __riscv_xlen == 32
+	if (misa_extension('H')) {
+		val = csr_read(CSR_MSTATUSH) & ~MSTATUSH_MPV;
+		csr_write(CSR_MSTATUSH, val | (win->mstatusH & MSTATUSH_MPV));
+	}
+#endif
+}
+
+/**
+ * Record a sample of the M-mode code interrupted in a profiling window.
+ *
+ * Called first thing from the trap handler. The caller chain is found by
+ * walking frame pointers, which OpenSBI is always built with.
+ *
+ * @param tcntx trap context of the interrupt
+ *
+ * @return true if the trap was taken in a profiling window and is done
+ */
+bool sbi_profile_sample(struct sbi_trap_context *tcntx)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct sbi_trap_regs *regs = &tcntx->regs;
+	struct sbi_profile_sample *sample;
+	struct sbi_trap_context *outer;
+	struct sbi_profile *prof;
+	unsigned long fp;
+	int i;
+
+	/* Only profiling windows run M-mode with interrupts enabled */
+	if (!(tcntx->trap.cause & MCAUSE_IRQ_MASK) ||
+	    sbi_mstatus_prev_mode(regs->mstatus) != PRV_M)
+		return false;
+
+	/* Close the window, MIE stays clear after MRET */
+	regs->mstatus &= ~MSTATUS_MPIE;
+
+	/* Other interrupts and M-mode timer events only end the window */
+	prof = profile_ptr_off ? profile_get(scratch) : NULL;
+	if (!prof ||
+	    tcntx->trap.cause != (MCAUSE_IRQ_MASK | IRQ_M_TIMER) ||
+	    !sbi_timer_event_pending(&prof->ev) ||
+	    sbi_timer_value() < prof->ev.expires ||
+	    prof->sampled == prof->ev.expires)
+		return true;
+	prof->sampled = prof->ev.expires;
+
+	sample = &prof->samples[prof->head++ % CONFIG_SBI_PROFILER_SAMPLES];
+	outer = sbi_trap_get_context(scratch);
+	sample->cause = outer ? outer->trap.cause : 0;
+	sample->pc[0] = regs->mepc;
+
+	/* Frame record: RA at fp - 8, caller FP at fp - 16 */
+	fp = regs->s0;
+	for (i = 1; i < SBI_PROFILE_DEPTH; i++) {
+		sample->pc[i] = profile_fp_valid(scratch, fp) ?
+				((unsigned long *)fp)[-1] : 0;
+		if (!sample->pc[i])
+			break;
+		fp = ((unsigned long *)fp)[-2];
+	}
+	for (; i < SBI_PROFILE_DEPTH; i++)
+		sample->pc[i] = 0;
+
+	return true;
+}
+
+/**
+ * Print the samples of all HARTs on the console.
+ *
+ * Each sample is printed as one line:
+ *   PROF <hartid> <mcause> <pc> <caller> ...
+ * preceded by the runtime firmware base so that the samples can be
+ * symbolized against the firmware ELF by scripts/sbi-profile.py.
+ */
+void sbi_profile_dump(void)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct sbi_profile_sample *sample;
+	struct sbi_profile *prof;
+	unsigned long i, n;
+	int d;
+
+	if (!profile_ptr_off)
+		return;
+
+	sbi_printf("PROF base 0x%lx\n", scratch->fw_start);
+	sbi_for_each_hartindex(hartindex) {
+		scratch = sbi_hartindex_to_scratch(hartindex);
+		prof = scratch ? profile_get(scratch) : NULL;
+		if (!prof)
+			continue;
+
+		n = prof->head < CONFIG_SBI_PROFILER_SAMPLES ?
+			prof->head : CONFIG_SBI_PROFILER_SAMPLES;
+		for (i = prof->head - n; i < prof->head; i++) {
+			sample = &prof->samples[i % CONFIG_SBI_PROFILER_SAMPLES];
+			sbi_printf("PROF %u 0x%lx",
+				   sbi_hartindex_to_hartid(hartindex),
+				   sample->cause);
+			for (d = 0; d < SBI_PROFILE_DEPTH && sample->pc[d]; d++)
+				sbi_printf(" 0x%lx", sample->pc[d]);
+			sbi_printf("\n");
+		}
+	}
+	sbi_printf("PROF end\n");
+}
+
+int sbi_profile_init(struct sbi_scratch *scratch, bool cold_boot)
+{
+	struct sbi_profile *prof;
+
+	if (cold_boot) {
+		profile_ptr_off = sbi_scratch_alloc_type_offset(void *);
+		if (!profile_ptr_off)
+			return SBI_ENOMEM;
+	} else if (!profile_ptr_off) {
+		return SBI_ENOMEM;
+	}
+
+	prof = profile_get(scratch);
+	if (!prof) {
+		prof = sbi_zalloc(sizeof(*prof));
+		if (!prof)
+			return SBI_ENOMEM;
+		sbi_timer_event_init(&prof->ev, profile_timer_fn, NULL);
+		profile_set(scratch, prof);
+	}
+
+	/* Timer events stay pending across HART stop and start */
+	if (!sbi_timer_event_pending(&prof->ev))
+		sbi_timer_add_event(&prof->ev, sbi_timer_value() +
+					       CONFIG_SBI_PROFILER_PERIOD);
+
+	return 0;
+}
@@ -8,6 +8,7 @@
  */
 
 #include <sbi/riscv_locks.h>
+#include <sbi/sbi_error.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_hartmask.h>
 #include <sbi/sbi_platform.h>
@@ -19,6 +20,10 @@
 u32 sbi_scratch_hart_count;
 u32 hartindex_to_hartid_table[SBI_HARTMASK_MAX_BITS] = { [0 ... SBI_HARTMASK_MAX_BITS-1] = -1U };
 struct sbi_scratch *hartindex_to_scratch_table[SBI_HARTMASK_MAX_BITS];
+static struct sbi_hartid_map hartid_to_hartindex_map;
+
+_Static_assert(SBI_HARTID_MAP_SIZE >= 2 * SBI_HARTMASK_MAX_BITS,
+	       "HART id map must stay at most half full, grow SBI_HARTID_MAP_BITS");
 
 static spinlock_t extra_lock = SPIN_LOCK_INITIALIZER;
 static unsigned long extra_offset = SBI_SCRATCH_EXTRA_SPACE_OFFSET;
@@ -36,8 +41,77 @@ static unsigned long sbi_get_scratch_alloc_align(void)
 	return plat->cbom_block_size;
 }
 
+static inline u32 hartid_map_hash(u32 hartid)
+{
+	/* Multiplicative hashing keeps the well mixed top bits */
+	return (hartid * 0x9e3779b1U) >> (32 - SBI_HARTID_MAP_BITS);
+}
+
+int sbi_hartid_map_build(struct sbi_hartid_map *map, const u32 *hartids,
+			 u32 count)
+{
+	u32 i, slot, max_hartid = 0;
+
+	if (!map || !hartids || count > SBI_HARTID_MAP_SIZE / 2)
+		return SBI_EINVAL;
+
+	map->ready = false;
+	for (i = 0; i < count; i++)
+		max_hartid = MAX(max_hartid, hartids[i]);
+	map->direct = max_hartid < SBI_HARTID_MAP_SIZE;
+
+	sbi_memset(map->hartid, 0xff, sizeof(map->hartid));
+	sbi_memset(map->hartindex, 0xff, sizeof(map->hartindex));
+
+	for (i = 0; i < count; i++) {
+		if (map->direct) {
+			/* Keep the lowest HART index for duplicate HART ids */
+			if (map->hartindex[hartids[i]] == (u16)-1)
+				map->hartindex[hartids[i]] = i;
+			continue;
+		}
+
+		slot = hartid_map_hash(hartids[i]);
+		while (map->hartid[slot] != -1U &&
+		       map->hartid[slot] != hartids[i])
+			slot = (slot + 1) & (SBI_HARTID_MAP_SIZE - 1);
+		if (map->hartid[slot] == hartids[i])
+			continue;
+		map->hartid[slot] = hartids[i];
+		map->hartindex[slot] = i;
+	}
+
+	map->ready = true;
+	return 0;
+}
+
+u32 sbi_hartid_map_lookup(const struct sbi_hartid_map *map, u32 hartid)
+{
+	u32 slot;
+
+	if (map->direct) {
+		if (hartid >= SBI_HARTID_MAP_SIZE ||
+		    map->hartindex[hartid] == (u16)-1)
+			return -1U;
+		return map->hartindex[hartid];
+	}
+
+	/* The table is at most half full so a free slot ends the probe */
+	slot = hartid_map_hash(hartid);
+	while (map->hartid[slot] != -1U) {
+		if (map->hartid[slot] == hartid)
+			return map->hartindex[slot];
+		slot = (slot + 1) & (SBI_HARTID_MAP_SIZE - 1);
+	}
+
+	return -1U;
+}
+
 u32 sbi_hartid_to_hartindex(u32 hartid)
 {
+	if (likely(hartid_to_hartindex_map.ready))
+		return sbi_hartid_map_lookup(&hartid_to_hartindex_map, hartid);
+
 	sbi_for_each_hartindex(i)
 		if (hartindex_to_hartid_table[i] == hartid)
 			return i;
@@ -64,7 +138,8 @@ int sbi_scratch_init(struct sbi_scratch *scratch)
 			((hartid2scratch)scratch->hartid_to_scratch)(h, i);
 	}
 
-	return 0;
+	return sbi_hartid_map_build(&hartid_to_hartindex_map,
+				    hartindex_to_hartid_table, hart_count);
 }
 
 unsigned long sbi_scratch_alloc_offset(unsigned long size)
@@ -14,9 +14,11 @@
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_hsm.h>
 #include <sbi/sbi_platform.h>
+#include <sbi/sbi_profile.h>
 #include <sbi/sbi_system.h>
 #include <sbi/sbi_ipi.h>
 #include <sbi/sbi_init.h>
+#include <sbi/sbi_latency.h>
 #include <sbi/sbi_timer.h>
 
 static SBI_LIST_HEAD(reset_devices_list);
@@ -71,6 +73,9 @@ void __noreturn sbi_system_reset(u32 reset_type, u32 reset_reason)
 	/* Send HALT IPI to every hart other than the current hart */
 	sbi_ipi_send_halt(0, -1UL);
 
+	sbi_profile_dump();
+	sbi_latency_dump_all();
+
 	/* Stop current HART */
 	sbi_hsm_hart_stop(scratch, false);
 
@@ -10,18 +10,41 @@
 #include <sbi/riscv_asm.h>
 #include <sbi/riscv_barrier.h>
 #include <sbi/riscv_encoding.h>
+#include <sbi/riscv_io.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_hart.h>
+#include <sbi/sbi_hartmask.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_pmu.h>
+#include <sbi/sbi_profile.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_timer.h>
 
+/** Per-HART state of the timer events */
+struct timer_hart {
+	/** Pending M-mode timer events sorted by expiry */
+	struct sbi_dlist events;
+	/** Next supervisor timer event if Sstc is not used (-1 if none) */
+	u64 smode_next;
+	/** Compare register usable by the set_timer fast path */
+	unsigned long fast_timecmp;
+	/** The set_timer fast path is off while set_timer is counted */
+	bool fast_blocked;
+	/** Deadline in the compare register while MTIE is set */
+	u64 armed;
+	/** Supervisor timer compare writes done and skipped */
+	struct sbi_timer_coalesce_stats coalesce;
+};
+
 static unsigned long time_delta_off;
+static unsigned long timer_hart_off;
 static u64 (*get_time_val)(void);
 static const struct sbi_timer_device *timer_dev = NULL;
 
+#define timer_hart_ptr(__scratch)					\
+	((struct timer_hart *)sbi_scratch_offset_ptr((__scratch), timer_hart_off))
+
 #if __riscv_xlen == 32
 static u64 get_ticks(void)
 {
@@ -44,14 +67,52 @@ static u64 get_ticks(void)
 }
 #endif
 
-static void nop_delay_fn(void *opaque)
+/* Interval at which sbi_timer_waitms_until() polls its predicate */
+#define TIMER_WAIT_POLL_US		10
+
+static void timer_wake_fn(struct sbi_timer_event *ev)
+{
+}
+
+/*
+ * Sleep until the timer reaches the deadline or any other interrupt
+ * enabled in MIE becomes pending. WFI wakes up on these even though
+ * M-mode runs with MSTATUS.MIE clear, so nothing is taken here and the
+ * caller must check the time again.
+ *
+ * The wake-up event stays armed across calls and is only moved when
+ * the deadline changes, so a wait costs one compare register write
+ * per deadline instead of two per WFI. The caller deletes it once the
+ * wait is over. Returns false if WFI would not sleep because another
+ * interrupt or an expired timer deadline is already pending, or if no
+ * M-mode timer event could be armed, in which case the caller has to
+ * spin.
+ */
+static bool timer_sleep_until(struct sbi_timer_event *ev, u64 deadline)
 {
-	cpu_relax();
+	struct timer_hart *th;
+
+	if (csr_read(CSR_MIP) & csr_read(CSR_MIE) & ~MIP_MTIP)
+		return false;
+
+	if (!sbi_timer_event_pending(ev) || ev->expires != deadline) {
+		if (sbi_timer_add_event(ev, deadline))
+			return false;
+	}
+
+	th = timer_hart_ptr(sbi_scratch_thishart_ptr());
+	if ((csr_read(CSR_MIP) & MIP_MTIP) || th->armed <= get_time_val())
+		return false;
+
+	wfi();
+	return true;
 }
 
 void sbi_timer_delay_loop(ulong units, u64 unit_freq,
 			  void (*delay_fn)(void *), void *opaque)
 {
+	struct sbi_profile_window win;
+	struct sbi_timer_event ev;
 	u64 start_val, delta;
 
 	/* Do nothing if we don't have timer device */
@@ -67,26 +128,57 @@ void sbi_timer_delay_loop(ulong units, u64 unit_freq,
 	delta = ((u64)timer_dev->timer_freq * (u64)units);
 	delta = delta / unit_freq;
 
-	/* Use NOP delay function if delay function not available */
-	if (!delay_fn)
-		delay_fn = nop_delay_fn;
-
-	/* Busy loop until desired timer value delta reached */
-	while ((get_time_val() - start_val) < delta)
-		delay_fn(opaque);
+	/*
+	 * Loop until desired timer value delta reached, sleeping until
+	 * the deadline unless the caller provided a delay function.
+	 */
+	sbi_timer_event_init(&ev, timer_wake_fn, NULL);
+	while ((get_time_val() - start_val) < delta) {
+		/* Platform delay functions may hold locks, never nest in them */
+		if (delay_fn) {
+			delay_fn(opaque);
+			continue;
+		}
+
+		sbi_profile_enter(&win);
+		if (!timer_sleep_until(&ev, start_val + delta))
+			cpu_relax();
+		sbi_profile_exit(&win);
+	}
+	sbi_timer_del_event(&ev);
 }
 
 bool sbi_timer_waitms_until(bool (*predicate)(void *), void *arg,
 			    uint64_t timeout_ms)
 {
+	u64 freq = sbi_timer_get_device()->timer_freq;
 	uint64_t start_time = sbi_timer_value();
-	uint64_t ticks =
-		(sbi_timer_get_device()->timer_freq / 1000) *
-		timeout_ms;
-	while(!predicate(arg))
-		if (sbi_timer_value() - start_time  >= ticks)
-			return false;
-	return true;
+	uint64_t ticks = (freq / 1000) * timeout_ms;
+	uint64_t poll = MAX((freq * TIMER_WAIT_POLL_US) / 1000000, 1ULL);
+	uint64_t now, next = start_time;
+	struct sbi_profile_window win;
+	struct sbi_timer_event ev;
+	bool ret = true;
+
+	/* Sleep between checks of the predicate */
+	sbi_timer_event_init(&ev, timer_wake_fn, NULL);
+	while (!predicate(arg)) {
+		now = sbi_timer_value();
+		if (now - start_time >= ticks) {
+			ret = false;
+			break;
+		}
+		/* Move the wake-up deadline only once the last one passed */
+		if (now >= next)
+			next = MIN(now + poll, start_time + ticks);
+		sbi_profile_enter(&win);
+		if (!timer_sleep_until(&ev, next))
+			cpu_relax();
+		sbi_profile_exit(&win);
+	}
+	sbi_timer_del_event(&ev);
+
+	return ret;
 }
 
 u64 sbi_timer_value(void)
@@ -130,35 +222,234 @@ void sbi_timer_set_delta_upper(ulong delta_upper)
 }
 #endif
 
+/*
+ * The set_timer fast path in fw_base.S writes the supervisor deadline
+ * straight into the compare register, so pick it up from there before
+ * the compare register is shared with M-mode timer events.
+ */
+static void timer_fast_sync(struct sbi_scratch *scratch, struct timer_hart *th)
+{
+#if defined(CONFIG_SBI_ECALL_FAST_TIMER) && __riscv_xlen == 64
+	if (!scratch->fast_timecmp ||
+	    scratch->fast_timecmp == SBI_SCRATCH_FAST_TIMECMP_SSTC)
+		return;
+
+	if (csr_read(CSR_MIE) & MIP_MTIP)
+		th->smode_next = readq((void *)scratch->fast_timecmp);
+	else
+		th->smode_next = -1ULL;
+#endif
+}
+
+/*
+ * Publish the compare register to the set_timer fast path unless it is
+ * blocked, or M-mode events share the MTIMER compare register.
+ */
+static void timer_fast_publish(struct sbi_scratch *scratch,
+			       struct timer_hart *th)
+{
+	if (th->fast_blocked)
+		scratch->fast_timecmp = 0;
+	else if (th->fast_timecmp == SBI_SCRATCH_FAST_TIMECMP_SSTC ||
+		 sbi_list_empty(&th->events))
+		scratch->fast_timecmp = th->fast_timecmp;
+	else
+		scratch->fast_timecmp = 0;
+}
+
+/* Program the compare register with the earliest event of the HART */
+static void timer_program(struct sbi_scratch *scratch, struct timer_hart *th)
+{
+	struct sbi_timer_event *ev;
+	u64 next = th->smode_next;
+
+	if (!sbi_list_empty(&th->events)) {
+		ev = sbi_list_first_entry(&th->events,
+					  struct sbi_timer_event, node);
+		if (ev->expires < next)
+			next = ev->expires;
+	}
+
+	timer_fast_publish(scratch, th);
+
+	if (next == -1ULL) {
+		th->armed = -1ULL;
+		csr_clear(CSR_MIE, MIP_MTIP);
+		return;
+	}
+
+	th->armed = next;
+	timer_dev->timer_event_start(next);
+	csr_set(CSR_MIE, MIP_MTIP);
+}
+
+/*
+ * Decide whether a new supervisor deadline can leave the compare
+ * register alone. Writing it is an MMIO access which can be slow.
+ */
+static bool timer_coalesce(struct timer_hart *th, u64 next_event)
+{
+#ifdef CONFIG_SBI_TIMER_COALESCE
+	u64 armed = th->armed;
+
+	if (armed == -1ULL)
+		return false;
+
+	/* Close enough, fire at the armed deadline instead */
+	if ((next_event > armed ? next_event - armed : armed - next_event) <=
+	    CONFIG_SBI_TIMER_COALESCE_SLACK) {
+		th->smode_next = armed;
+		th->coalesce.skipped_slack++;
+		return true;
+	}
+
+	/*
+	 * Later than the armed deadline, which has not fired yet. Once it
+	 * fires sbi_timer_process() finds the supervisor deadline not yet
+	 * reached and reprograms the compare register.
+	 */
+	if (next_event > armed) {
+		th->coalesce.skipped_later++;
+		return true;
+	}
+#endif
+
+	return false;
+}
+
 void sbi_timer_event_start(u64 next_event)
 {
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct timer_hart *th;
+
 	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_SET_TIMER);
 
 	/**
 	 * Update the stimecmp directly if available. This allows
 	 * the older software to leverage sstc extension on newer hardware.
+	 * The supervisor timer then never goes through the M-mode timer.
 	 */
-	if (sbi_hart_has_extension(sbi_scratch_thishart_ptr(), SBI_HART_EXT_SSTC)) {
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SSTC)) {
 		csr_write64(CSR_STIMECMP, next_event);
 	} else if (timer_dev && timer_dev->timer_event_start) {
-		timer_dev->timer_event_start(next_event);
+		th = timer_hart_ptr(scratch);
+		th->smode_next = next_event;
 		csr_clear(CSR_MIP, MIP_STIP);
+		if (timer_coalesce(th, next_event))
+			return;
+		th->coalesce.writes++;
+		timer_program(scratch, th);
 	}
-	csr_set(CSR_MIE, MIP_MTIP);
+}
+
+const struct sbi_timer_coalesce_stats *
+sbi_timer_get_coalesce_stats(u32 hartindex)
+{
+#ifdef CONFIG_SBI_TIMER_COALESCE
+	struct sbi_scratch *scratch = sbi_hartindex_to_scratch(hartindex);
+
+	if (scratch && timer_hart_off)
+		return &timer_hart_ptr(scratch)->coalesce;
+#endif
+
+	return NULL;
 }
 
 void sbi_timer_process(void)
 {
-	csr_clear(CSR_MIE, MIP_MTIP);
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct timer_hart *th = timer_hart_ptr(scratch);
+	struct sbi_timer_event *ev;
+	u64 now;
+
+	if (!timer_dev || !timer_dev->timer_event_start) {
+		csr_clear(CSR_MIE, MIP_MTIP);
+		return;
+	}
+
+	timer_fast_sync(scratch, th);
+	now = sbi_timer_value();
+
+	while (!sbi_list_empty(&th->events)) {
+		ev = sbi_list_first_entry(&th->events,
+					  struct sbi_timer_event, node);
+		if (ev->expires > now)
+			break;
+		sbi_list_del_init(&ev->node);
+		ev->callback(ev);
+	}
+
 	/*
 	 * If sstc extension is available, supervisor can receive the timer
-	 * directly without M-mode come in between. This function should
-	 * only invoked if M-mode programs the timer for its own purpose.
+	 * directly without M-mode come in between, so only the M-mode
+	 * timer events are handled here.
 	 */
-	if (!sbi_hart_has_extension(sbi_scratch_thishart_ptr(), SBI_HART_EXT_SSTC))
+	if (th->smode_next <= now) {
+		th->smode_next = -1ULL;
 		csr_set(CSR_MIP, MIP_STIP);
+	}
+
+	timer_program(scratch, th);
 }
 
+int sbi_timer_add_event(struct sbi_timer_event *ev, u64 expires)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct timer_hart *th = timer_hart_ptr(scratch);
+	struct sbi_timer_event *pos;
+
+	if (!ev || !ev->callback)
+		return SBI_EINVAL;
+	if (!timer_dev || !timer_dev->timer_event_start ||
+	    !timer_hart_off || !th->events.next)
+		return SBI_ENODEV;
+
+	timer_fast_sync(scratch, th);
+	sbi_list_del_init(&ev->node);
+	ev->expires = expires;
+
+	/* Few events are pending at a time so keep them in a sorted list */
+	sbi_list_for_each_entry(pos, &th->events, node) {
+		if (expires < pos->expires)
+			break;
+	}
+	sbi_list_add_tail(&ev->node, &pos->node);
+
+	timer_program(scratch, th);
+
+	return 0;
+}
+
+void sbi_timer_del_event(struct sbi_timer_event *ev)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct timer_hart *th = timer_hart_ptr(scratch);
+
+	if (!ev || !sbi_timer_event_pending(ev))
+		return;
+
+	timer_fast_sync(scratch, th);
+	sbi_list_del_init(&ev->node);
+	timer_program(scratch, th);
+}
+
+#ifdef CONFIG_SBI_ECALL_FAST_TIMER
+void sbi_timer_fast_path_allow(bool allow)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct timer_hart *th;
+
+	if (!timer_hart_off)
+		return;
+
+	/* Pick up a deadline written by the fast path before blocking it */
+	th = timer_hart_ptr(scratch);
+	timer_fast_sync(scratch, th);
+	th->fast_blocked = !allow;
+	timer_fast_publish(scratch, th);
+}
+#endif
+
 const struct sbi_timer_device *sbi_timer_get_device(void)
 {
 	return timer_dev;
@@ -176,6 +467,7 @@ void sbi_timer_set_device(const struct sbi_timer_device *dev)
 
 int sbi_timer_init(struct sbi_scratch *scratch, bool cold_boot)
 {
+	struct timer_hart *th;
 	u64 *time_delta;
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
 	int ret;
@@ -185,6 +477,10 @@ int sbi_timer_init(struct sbi_scratch *scratch, bool cold_boot)
 		if (!time_delta_off)
 			return SBI_ENOMEM;
 
+		timer_hart_off = sbi_scratch_alloc_offset(sizeof(*th));
+		if (!timer_hart_off)
+			return SBI_ENOMEM;
+
 		if (sbi_hart_has_csr(scratch, SBI_HART_CSR_TIME))
 			get_time_val = get_ticks;
 
@@ -192,7 +488,7 @@ int sbi_timer_init(struct sbi_scratch *scratch, bool cold_boot)
 		if (ret)
 			return ret;
 	} else {
-		if (!time_delta_off)
+		if (!time_delta_off || !timer_hart_off)
 			return SBI_ENOMEM;
 	}
 
@@ -205,14 +501,52 @@ int sbi_timer_init(struct sbi_scratch *scratch, bool cold_boot)
 			return ret;
 	}
 
+	/* M-mode timer events stay pending across HART stop and start */
+	th = timer_hart_ptr(scratch);
+	if (!th->events.next)
+		SBI_INIT_LIST_HEAD(&th->events);
+	th->smode_next = -1ULL;
+	th->armed = -1ULL;
+
+	/*
+	 * Let the set_timer ecall fast path program the timer directly.
+	 * It bypasses the latency histograms, so it is never used with
+	 * them, and the PMU firmware counters start out stopped.
+	 */
+	th->fast_timecmp = 0;
+	th->fast_blocked = false;
+#if defined(CONFIG_SBI_ECALL_FAST_TIMER) && !defined(CONFIG_SBI_LATENCY_HIST)
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SSTC))
+		th->fast_timecmp = SBI_SCRATCH_FAST_TIMECMP_SSTC;
+#ifndef CONFIG_SBI_TIMER_COALESCE
+	/* The fast path would bypass coalescing of MTIMER compare writes */
+	else if (timer_dev && timer_dev->timer_event_fast_cmp)
+		th->fast_timecmp =
+			(unsigned long)timer_dev->timer_event_fast_cmp();
+#endif
+#endif
+	timer_fast_publish(scratch, th);
+
+	if (!sbi_list_empty(&th->events))
+		timer_program(scratch, th);
+
 	return 0;
 }
 
 void sbi_timer_exit(struct sbi_scratch *scratch)
 {
+	struct timer_hart *th = timer_hart_ptr(scratch);
+
+	th->smode_next = -1ULL;
+	th->armed = -1ULL;
+
 	if (timer_dev && timer_dev->timer_event_stop)
 		timer_dev->timer_event_stop();
 
+	/* STIP follows stimecmp with Sstc so clearing MIP is not enough */
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SSTC))
+		csr_write64(CSR_STIMECMP, -1ULL);
+
 	csr_clear(CSR_MIP, MIP_STIP);
 	csr_clear(CSR_MIE, MIP_MTIP);
 }
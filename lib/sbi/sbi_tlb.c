@@ -11,8 +11,10 @@
 #include <sbi/riscv_asm.h>
 #include <sbi/riscv_atomic.h>
 #include <sbi/riscv_barrier.h>
+#include <sbi/sbi_bitops.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_fifo.h>
+#include <sbi/sbi_mpsc_fifo.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_heap.h>
 #include <sbi/sbi_ipi.h>
@@ -23,34 +25,130 @@
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_pmu.h>
+#include <sbi/sbi_profile.h>
+
+/*
+ * With Svinval, a range is invalidated by a run of SINVAL/HINVAL between a
+ * single pair of fences so much larger ranges are still cheaper than a full
+ * flush. Used when the range flush limit can't be calibrated.
+ */
+#define TLB_SVINVAL_RANGE_FLUSH_LIMIT	(64UL * PAGE_SIZE)
+
+/* Number of pages flushed one by one to calibrate range flush limits */
+#define TLB_CALIB_PAGES			16
+
+/* Upper bound of calibrated range flush limits in pages */
+#define TLB_CALIB_MAX_PAGES		512
+
+/*
+ * A full flush also drops every unrelated translation of the hart. The
+ * page table walks refilling them happen later in S-mode, where they
+ * can't be timed, so the measured cost of a full flush is weighed up.
+ */
+#define TLB_FULL_FLUSH_WEIGHT		CONFIG_SBI_TLB_FULL_FLUSH_WEIGHT
+
+/** Fence classes which have their own range flush limit */
+enum tlb_limit_class {
+	TLB_LIMIT_SFENCE = 0,
+	TLB_LIMIT_HFENCE_GVMA,
+	TLB_LIMIT_HFENCE_VVMA,
+	TLB_LIMIT_CLASS_MAX,
+};
+
+/** Per-hart range flush limits */
+struct sbi_tlb_limits {
+	/** Largest range (in bytes) flushed page by page */
+	unsigned long limit[TLB_LIMIT_CLASS_MAX];
+	/** Cycles spent per page by a range flush (zero if unknown) */
+	unsigned long page_cycles[TLB_LIMIT_CLASS_MAX];
+	/** Cycles spent by a full flush (zero if unknown) */
+	unsigned long full_cycles[TLB_LIMIT_CLASS_MAX];
+};
+
+/** Broadcast fence descriptor owned by the sending hart */
+struct sbi_tlb_bcast {
+	struct sbi_tlb_info info;
+	/** Number of target harts yet to acknowledge the request */
+	atomic_t pending;
+#ifdef CONFIG_SBI_TLB_TREE_FANOUT
+	/** Relay the request through a tree of the target harts */
+	bool tree;
+	/** Target harts, ordered by hart index to form the tree */
+	struct sbi_hartmask targets;
+#endif
+};
 
 static unsigned long tlb_sync_off;
 static unsigned long tlb_fifo_off;
 static unsigned long tlb_fifo_mem_off;
+static unsigned long tlb_bcast_off;
+static unsigned long tlb_bcast_pend_off;
+static unsigned long tlb_limits_off;
+static unsigned long tlb_stats_off;
+static unsigned long tlb_fence_i_epoch_off;
 static unsigned long tlb_range_flush_limit;
+static unsigned long tlb_svinval_flush_limit;
+static unsigned long tlb_request_flush_limit;
+static u32 tlb_event = SBI_IPI_EVENT_MAX;
+static u32 tlb_bcast_event = SBI_IPI_EVENT_MAX;
+
+/*
+ * Global FENCE.I epoch. Every remote FENCE.I request takes a new epoch and
+ * every hart records the epoch it sampled before its last FENCE.I, so a
+ * hart whose recorded epoch is at least the epoch of a request has already
+ * executed a FENCE.I after the request was issued.
+ */
+static atomic_t tlb_fence_i_epoch = ATOMIC_INITIALIZER(0);
 
 static void tlb_flush_all(void)
 {
 	__asm__ __volatile("sfence.vma");
 }
 
+static bool tlb_has_svinval(void)
+{
+	return sbi_hart_has_extension(sbi_scratch_thishart_ptr(),
+				      SBI_HART_EXT_SVINVAL);
+}
+
+static bool tlb_range_is_flush_all(unsigned long start, unsigned long size,
+				   u32 class)
+{
+	struct sbi_tlb_limits *limits;
+
+	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL))
+		return true;
+
+	limits = sbi_scratch_thishart_offset_ptr(tlb_limits_off);
+	return size > limits->limit[class];
+}
+
 static void sbi_tlb_local_hfence_vvma(struct sbi_tlb_info *tinfo)
 {
 	unsigned long start = tinfo->start;
 	unsigned long size  = tinfo->size;
 	unsigned long vmid  = tinfo->vmid;
 	unsigned long i, hgatp;
+	bool svinval = tlb_has_svinval();
 
 	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_HFENCE_VVMA_RCVD);
 
 	hgatp = csr_swap(CSR_HGATP,
 			 (vmid << HGATP_VMID_SHIFT) & HGATP_VMID_MASK);
 
-	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL)) {
+	if (tlb_range_is_flush_all(start, size, TLB_LIMIT_HFENCE_VVMA)) {
 		__sbi_hfence_vvma_all();
 		goto done;
 	}
 
+	if (svinval) {
+		__sbi_sfence_w_inval();
+		for (i = 0; i < size; i += PAGE_SIZE)
+			__sbi_hinval_vvma_va(start + i);
+		__sbi_sfence_inval_ir();
+		goto done;
+	}
+
 	for (i = 0; i < size; i += PAGE_SIZE) {
 		__sbi_hfence_vvma_va(start+i);
 	}
@@ -64,14 +162,23 @@ static void sbi_tlb_local_hfence_gvma(struct sbi_tlb_info *tinfo)
 	unsigned long start = tinfo->start;
 	unsigned long size  = tinfo->size;
 	unsigned long i;
+	bool svinval = tlb_has_svinval();
 
 	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_HFENCE_GVMA_RCVD);
 
-	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL)) {
+	if (tlb_range_is_flush_all(start, size, TLB_LIMIT_HFENCE_GVMA)) {
 		__sbi_hfence_gvma_all();
 		return;
 	}
 
+	if (svinval) {
+		__sbi_sfence_w_inval();
+		for (i = 0; i < size; i += PAGE_SIZE)
+			__sbi_hinval_gvma_gpa((start + i) >> 2);
+		__sbi_sfence_inval_ir();
+		return;
+	}
+
 	for (i = 0; i < size; i += PAGE_SIZE) {
 		__sbi_hfence_gvma_gpa((start + i) >> 2);
 	}
@@ -82,14 +189,23 @@ static void sbi_tlb_local_sfence_vma(struct sbi_tlb_info *tinfo)
 	unsigned long start = tinfo->start;
 	unsigned long size  = tinfo->size;
 	unsigned long i;
+	bool svinval = tlb_has_svinval();
 
 	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_SFENCE_VMA_RCVD);
 
-	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL)) {
+	if (tlb_range_is_flush_all(start, size, TLB_LIMIT_SFENCE)) {
 		tlb_flush_all();
 		return;
 	}
 
+	if (svinval) {
+		__sbi_sfence_w_inval();
+		for (i = 0; i < size; i += PAGE_SIZE)
+			__sbi_sinval_vma_va(start + i);
+		__sbi_sfence_inval_ir();
+		return;
+	}
+
 	for (i = 0; i < size; i += PAGE_SIZE) {
 		__asm__ __volatile__("sfence.vma %0"
 				     :
@@ -105,17 +221,26 @@ static void sbi_tlb_local_hfence_vvma_asid(struct sbi_tlb_info *tinfo)
 	unsigned long asid  = tinfo->asid;
 	unsigned long vmid  = tinfo->vmid;
 	unsigned long i, hgatp;
+	bool svinval = tlb_has_svinval();
 
 	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_HFENCE_VVMA_ASID_RCVD);
 
 	hgatp = csr_swap(CSR_HGATP,
 			 (vmid << HGATP_VMID_SHIFT) & HGATP_VMID_MASK);
 
-	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL)) {
+	if (tlb_range_is_flush_all(start, size, TLB_LIMIT_HFENCE_VVMA)) {
 		__sbi_hfence_vvma_asid(asid);
 		goto done;
 	}
 
+	if (svinval) {
+		__sbi_sfence_w_inval();
+		for (i = 0; i < size; i += PAGE_SIZE)
+			__sbi_hinval_vvma_asid_va(start + i, asid);
+		__sbi_sfence_inval_ir();
+		goto done;
+	}
+
 	for (i = 0; i < size; i += PAGE_SIZE) {
 		__sbi_hfence_vvma_asid_va(start + i, asid);
 	}
@@ -130,14 +255,23 @@ static void sbi_tlb_local_hfence_gvma_vmid(struct sbi_tlb_info *tinfo)
 	unsigned long size  = tinfo->size;
 	unsigned long vmid  = tinfo->vmid;
 	unsigned long i;
+	bool svinval = tlb_has_svinval();
 
 	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_HFENCE_GVMA_VMID_RCVD);
 
-	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL)) {
+	if (tlb_range_is_flush_all(start, size, TLB_LIMIT_HFENCE_GVMA)) {
 		__sbi_hfence_gvma_vmid(vmid);
 		return;
 	}
 
+	if (svinval) {
+		__sbi_sfence_w_inval();
+		for (i = 0; i < size; i += PAGE_SIZE)
+			__sbi_hinval_gvma_vmid_gpa((start + i) >> 2, vmid);
+		__sbi_sfence_inval_ir();
+		return;
+	}
+
 	for (i = 0; i < size; i += PAGE_SIZE) {
 		__sbi_hfence_gvma_vmid_gpa((start + i) >> 2, vmid);
 	}
@@ -149,11 +283,12 @@ static void sbi_tlb_local_sfence_vma_asid(struct sbi_tlb_info *tinfo)
 	unsigned long size  = tinfo->size;
 	unsigned long asid  = tinfo->asid;
 	unsigned long i;
+	bool svinval = tlb_has_svinval();
 
 	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_SFENCE_VMA_ASID_RCVD);
 
 	/* Flush entire MM context for a given ASID */
-	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL)) {
+	if (tlb_range_is_flush_all(start, size, TLB_LIMIT_SFENCE)) {
 		__asm__ __volatile__("sfence.vma x0, %0"
 				     :
 				     : "r"(asid)
@@ -161,6 +296,14 @@ static void sbi_tlb_local_sfence_vma_asid(struct sbi_tlb_info *tinfo)
 		return;
 	}
 
+	if (svinval) {
+		__sbi_sfence_w_inval();
+		for (i = 0; i < size; i += PAGE_SIZE)
+			__sbi_sinval_vma_asid_va(start + i, asid);
+		__sbi_sfence_inval_ir();
+		return;
+	}
+
 	for (i = 0; i < size; i += PAGE_SIZE) {
 		__asm__ __volatile__("sfence.vma %0, %1"
 				     :
@@ -169,18 +312,38 @@ static void sbi_tlb_local_sfence_vma_asid(struct sbi_tlb_info *tinfo)
 	}
 }
 
-static void sbi_tlb_local_fence_i(struct sbi_tlb_info *tinfo)
+static bool tlb_fence_i_done(struct sbi_scratch *scratch,
+			     struct sbi_tlb_info *tinfo)
 {
-	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_FENCE_I_RECVD);
+	unsigned long *epoch;
 
-	__asm__ __volatile("fence.i");
+	if (tinfo->type != SBI_TLB_FENCE_I || !tinfo->epoch)
+		return false;
+
+	epoch = sbi_scratch_offset_ptr(scratch, tlb_fence_i_epoch_off);
+	return (long)(__smp_load_acquire(epoch) - tinfo->epoch) >= 0;
 }
 
-static void tlb_entry_local_process(struct sbi_tlb_info *data)
+static void sbi_tlb_local_fence_i(struct sbi_tlb_info *tinfo)
 {
-	if (unlikely(!data))
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	unsigned long *epoch =
+			sbi_scratch_offset_ptr(scratch, tlb_fence_i_epoch_off);
+	unsigned long curr_epoch;
+
+	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_FENCE_I_RECVD);
+
+	/* Already fenced after this request was issued */
+	if (tlb_fence_i_done(scratch, tinfo))
 		return;
 
+	curr_epoch = atomic_read(&tlb_fence_i_epoch);
+	__asm__ __volatile("fence.i" ::: "memory");
+	__smp_store_release(epoch, curr_epoch);
+}
+
+static void __tlb_entry_local_process(struct sbi_tlb_info *data)
+{
 	switch (data->type) {
 	case SBI_TLB_FENCE_I:
 		sbi_tlb_local_fence_i(data);
@@ -208,6 +371,172 @@ static void tlb_entry_local_process(struct sbi_tlb_info *data)
 	};
 }
 
+static void tlb_limit_update(struct sbi_tlb_limits *limits, u32 class)
+{
+	unsigned long pages;
+
+	pages = limits->full_cycles[class] * TLB_FULL_FLUSH_WEIGHT /
+		limits->page_cycles[class];
+	pages = MIN(MAX(pages, 1UL), (unsigned long)TLB_CALIB_MAX_PAGES);
+	limits->limit[class] = pages * PAGE_SIZE;
+
+	/*
+	 * Senders only upgrade ranges which no hart would flush page by
+	 * page. Racing updates from other harts are harmless because
+	 * target harts always apply their own limit.
+	 */
+	if (tlb_request_flush_limit < limits->limit[class])
+		tlb_request_flush_limit = limits->limit[class];
+}
+
+#ifdef CONFIG_SBI_TLB_ONLINE_FLUSH_LIMIT
+static const u32 tlb_type_to_limit_class[SBI_TLB_TYPE_MAX] = {
+	[SBI_TLB_FENCE_I] = TLB_LIMIT_CLASS_MAX,
+	[SBI_TLB_SFENCE_VMA] = TLB_LIMIT_SFENCE,
+	[SBI_TLB_SFENCE_VMA_ASID] = TLB_LIMIT_SFENCE,
+	[SBI_TLB_HFENCE_GVMA_VMID] = TLB_LIMIT_HFENCE_GVMA,
+	[SBI_TLB_HFENCE_GVMA] = TLB_LIMIT_HFENCE_GVMA,
+	[SBI_TLB_HFENCE_VVMA_ASID] = TLB_LIMIT_HFENCE_VVMA,
+	[SBI_TLB_HFENCE_VVMA] = TLB_LIMIT_HFENCE_VVMA,
+};
+
+/* Fold an observed flush cost into the calibrated costs of this hart */
+static void tlb_limit_observe(struct sbi_tlb_info *tinfo, unsigned long cycles)
+{
+	u32 class = tlb_type_to_limit_class[tinfo->type];
+	struct sbi_tlb_limits *limits;
+	unsigned long pages;
+
+	if (class == TLB_LIMIT_CLASS_MAX)
+		return;
+
+	limits = sbi_scratch_thishart_offset_ptr(tlb_limits_off);
+	if (!limits->page_cycles[class])
+		return;
+
+	if (tlb_range_is_flush_all(tinfo->start, tinfo->size, class)) {
+		limits->full_cycles[class] =
+			(limits->full_cycles[class] * 7 + cycles) / 8;
+	} else {
+		pages = MAX(tinfo->size / PAGE_SIZE, 1UL);
+		limits->page_cycles[class] =
+			(limits->page_cycles[class] * 7 + cycles / pages) / 8;
+		if (!limits->page_cycles[class])
+			limits->page_cycles[class] = 1;
+	}
+
+	tlb_limit_update(limits, class);
+}
+#endif
+
+static void tlb_entry_local_process(struct sbi_tlb_info *data)
+{
+#ifdef CONFIG_SBI_TLB_ONLINE_FLUSH_LIMIT
+	unsigned long start_cycles;
+#endif
+	struct sbi_profile_window win;
+
+	if (unlikely(!data))
+		return;
+
+	/* Page by page flushes can take long, let the profiler see them */
+	sbi_profile_enter(&win);
+#ifdef CONFIG_SBI_TLB_ONLINE_FLUSH_LIMIT
+	start_cycles = csr_read(CSR_MCYCLE);
+	__tlb_entry_local_process(data);
+	tlb_limit_observe(data, csr_read(CSR_MCYCLE) - start_cycles);
+#else
+	__tlb_entry_local_process(data);
+#endif
+	sbi_profile_exit(&win);
+}
+
+/*
+ * Flush TLB_CALIB_PAGES pages, or everything, of one class of fences
+ * with the bare fence instructions. Calibration must not go through the
+ * request handlers, which count received fences in the PMU.
+ */
+static void tlb_calib_flush(u32 class, bool svinval, bool all)
+{
+	unsigned long va, end = (TLB_CALIB_PAGES + 1) * PAGE_SIZE;
+
+	if (all) {
+		if (class == TLB_LIMIT_SFENCE)
+			tlb_flush_all();
+		else if (class == TLB_LIMIT_HFENCE_GVMA)
+			__sbi_hfence_gvma_all();
+		else
+			__sbi_hfence_vvma_all();
+		return;
+	}
+
+	if (svinval) {
+		__sbi_sfence_w_inval();
+		for (va = PAGE_SIZE; va < end; va += PAGE_SIZE) {
+			if (class == TLB_LIMIT_SFENCE)
+				__sbi_sinval_vma_va(va);
+			else if (class == TLB_LIMIT_HFENCE_GVMA)
+				__sbi_hinval_gvma_gpa(va >> 2);
+			else
+				__sbi_hinval_vvma_va(va);
+		}
+		__sbi_sfence_inval_ir();
+		return;
+	}
+
+	for (va = PAGE_SIZE; va < end; va += PAGE_SIZE) {
+		if (class == TLB_LIMIT_SFENCE)
+			__asm__ __volatile__("sfence.vma %0"
+					     :
+					     : "r"(va)
+					     : "memory");
+		else if (class == TLB_LIMIT_HFENCE_GVMA)
+			__sbi_hfence_gvma_gpa(va >> 2);
+		else
+			__sbi_hfence_vvma_va(va);
+	}
+}
+
+/*
+ * Time a range flush of a few pages against a full flush on this hart to
+ * find out where a full flush becomes cheaper, separately for each class
+ * of fences. The platform limit is kept if the cycle counter is unusable.
+ */
+static void tlb_limits_calibrate(struct sbi_scratch *scratch)
+{
+	struct sbi_tlb_limits *limits =
+			sbi_scratch_offset_ptr(scratch, tlb_limits_off);
+	bool svinval = sbi_hart_has_extension(scratch, SBI_HART_EXT_SVINVAL);
+	unsigned long t0, t1, t2, fallback;
+	u32 class;
+
+	fallback = svinval ? tlb_svinval_flush_limit : tlb_range_flush_limit;
+	if (tlb_request_flush_limit < fallback)
+		tlb_request_flush_limit = fallback;
+
+	for (class = 0; class < TLB_LIMIT_CLASS_MAX; class++) {
+		limits->limit[class] = fallback;
+		limits->page_cycles[class] = 0;
+		limits->full_cycles[class] = 0;
+		if (class != TLB_LIMIT_SFENCE && !misa_extension('H'))
+			continue;
+
+		t0 = csr_read(CSR_MCYCLE);
+		tlb_calib_flush(class, svinval, false);
+		t1 = csr_read(CSR_MCYCLE);
+		tlb_calib_flush(class, svinval, true);
+		t2 = csr_read(CSR_MCYCLE);
+
+		if (t1 == t0 || t2 == t1)
+			continue;
+
+		limits->page_cycles[class] =
+			MAX((t1 - t0) / TLB_CALIB_PAGES, 1UL);
+		limits->full_cycles[class] = t2 - t1;
+		tlb_limit_update(limits, class);
+	}
+}
+
 static void tlb_entry_process(struct sbi_tlb_info *tinfo)
 {
 	u32 rindex;
@@ -226,18 +555,121 @@ static void tlb_entry_process(struct sbi_tlb_info *tinfo)
 	}
 }
 
+#ifdef CONFIG_SBI_TLB_TREE_FANOUT
+#define TLB_TREE_DEGREE		CONFIG_SBI_TLB_TREE_DEGREE
+
+/* Position of a hart among the targets of a tree broadcast */
+static long tlb_bcast_rank(const struct sbi_hartmask *targets, u32 hartindex)
+{
+	u32 i, word = BIT_WORD(hartindex);
+	long rank = 0;
+
+	for (i = 0; i < word; i++)
+		rank += sbi_popcount(sbi_hartmask_bits(targets)[i]);
+
+	return rank + sbi_popcount(sbi_hartmask_bits(targets)[word] &
+				   (BIT_MASK(hartindex) - 1));
+}
+
+/**
+ * Forward a tree broadcast of the sender to the children of the target at
+ * the given position. Targets form a k-ary tree in hart index order with
+ * the sender as root (position -1), so the target at position p notifies
+ * the targets at positions (p + 1) * k to (p + 1) * k + k - 1.
+ *
+ * Completion does not walk back up the tree: every target decrements the
+ * pending counter of the sender descriptor directly.
+ */
+static void tlb_bcast_relay(struct sbi_tlb_bcast *bcast, u32 sender,
+			    long pos)
+{
+	u32 i;
+	struct sbi_scratch *rscratch;
+	struct sbi_hartmask *pend, children;
+	unsigned long n = 0, first = (pos + 1) * TLB_TREE_DEGREE;
+
+	sbi_hartmask_clear_all(&children);
+	sbi_hartmask_for_each_hartindex(i, &bcast->targets) {
+		if (n >= first + TLB_TREE_DEGREE)
+			break;
+		if (n++ < first)
+			continue;
+		sbi_hartmask_set_hartindex(i, &children);
+	}
+	if (!sbi_hartmask_weight(&children))
+		return;
+
+	/* Children must observe the descriptor we have observed */
+	smp_mb();
+
+	sbi_hartmask_for_each_hartindex(i, &children) {
+		rscratch = sbi_hartindex_to_scratch(i);
+		if (!rscratch)
+			continue;
+		pend = sbi_scratch_offset_ptr(rscratch, tlb_bcast_pend_off);
+		atomic_raw_set_bit(sender, sbi_hartmask_bits(pend));
+	}
+
+	sbi_ipi_event_raise(&children, tlb_bcast_event);
+}
+#endif
+
+static bool tlb_bcast_process(struct sbi_scratch *scratch)
+{
+	u32 i, rindex;
+	bool ret = false;
+	unsigned long senders;
+	struct sbi_tlb_bcast *bcast;
+	struct sbi_scratch *rscratch;
+	struct sbi_hartmask *pend =
+			sbi_scratch_offset_ptr(scratch, tlb_bcast_pend_off);
+
+	for (i = 0; i < BITS_TO_LONGS(SBI_HARTMASK_MAX_BITS); i++) {
+		if (!sbi_hartmask_bits(pend)[i])
+			continue;
+
+		senders = atomic_raw_xchg_ulong(&sbi_hartmask_bits(pend)[i], 0);
+		while (senders) {
+			rindex = i * BITS_PER_LONG + sbi_ffs(senders);
+			senders &= senders - 1;
+
+			rscratch = sbi_hartindex_to_scratch(rindex);
+			if (!rscratch)
+				continue;
+
+			bcast = sbi_scratch_offset_ptr(rscratch, tlb_bcast_off);
+#ifdef CONFIG_SBI_TLB_TREE_FANOUT
+			/* Forward before fencing to keep the tree shallow in time */
+			if (bcast->tree)
+				tlb_bcast_relay(bcast, rindex,
+						tlb_bcast_rank(&bcast->targets,
+							       current_hartindex()));
+#endif
+			tlb_entry_local_process(&bcast->info);
+			atomic_sub_return(&bcast->pending, 1);
+			ret = true;
+		}
+	}
+
+	return ret;
+}
+
 static bool tlb_process_once(struct sbi_scratch *scratch)
 {
+	bool ret;
 	struct sbi_tlb_info tinfo;
-	struct sbi_fifo *tlb_fifo =
+	struct sbi_mpsc_fifo *tlb_fifo =
 			sbi_scratch_offset_ptr(scratch, tlb_fifo_off);
 
-	if (!sbi_fifo_dequeue(tlb_fifo, &tinfo)) {
+	/* Broadcast requests are cheap to find so always look at them */
+	ret = tlb_bcast_process(scratch);
+
+	if (!sbi_mpsc_fifo_dequeue(tlb_fifo, &tinfo)) {
 		tlb_entry_process(&tinfo);
 		return true;
 	}
 
-	return false;
+	return ret;
 }
 
 static void tlb_process(struct sbi_scratch *scratch)
@@ -249,53 +681,96 @@ static void tlb_sync(struct sbi_scratch *scratch)
 {
 	atomic_t *tlb_sync =
 			sbi_scratch_offset_ptr(scratch, tlb_sync_off);
+	long count;
 
-	while (atomic_read(tlb_sync) > 0) {
+	while ((count = atomic_read(tlb_sync)) > 0) {
 		/*
 		 * While we are waiting for remote hart to set the sync,
-		 * consume fifo requests to avoid deadlock.
+		 * consume fifo requests to avoid deadlock. Sleep on the
+		 * sync counter only when there was nothing to consume.
 		 */
-		tlb_process_once(scratch);
+		if (!tlb_process_once(scratch))
+			sbi_hart_wait_value(&tlb_sync->counter, count);
 	}
 
 	return;
 }
 
+static inline bool tlb_range_is_all(struct sbi_tlb_info *tinfo)
+{
+	return (tinfo->start == 0 && tinfo->size == 0) ||
+	       (tinfo->size == SBI_TLB_FLUSH_ALL);
+}
+
+static inline unsigned long tlb_range_end(struct sbi_tlb_info *tinfo)
+{
+	/* Saturate instead of wrapping around the address space */
+	if (tinfo->size > -1UL - tinfo->start)
+		return -1UL;
+
+	return tinfo->start + tinfo->size;
+}
+
 static inline int tlb_range_check(struct sbi_tlb_info *curr,
 					struct sbi_tlb_info *next)
 {
 	unsigned long curr_end;
 	unsigned long next_end;
-	int ret = SBI_FIFO_UNCHANGED;
 
 	if (!curr || !next)
-		return ret;
+		return SBI_FIFO_UNCHANGED;
+
+	/* FENCE.I has no range, a pending one only needs the newest epoch */
+	if (curr->type == SBI_TLB_FENCE_I) {
+		if ((long)(next->epoch - curr->epoch) <= 0)
+			goto skip;
+		curr->epoch = next->epoch;
+		goto updated;
+	}
 
-	next_end = next->start + next->size;
-	curr_end = curr->start + curr->size;
-	if (next->start <= curr->start && next_end > curr_end) {
-		curr->start = next->start;
-		curr->size  = next->size;
-		sbi_hartmask_or(&curr->smask, &curr->smask, &next->smask);
-		ret = SBI_FIFO_UPDATED;
-	} else if (next->start >= curr->start && next_end <= curr_end) {
-		sbi_hartmask_or(&curr->smask, &curr->smask, &next->smask);
-		ret = SBI_FIFO_SKIP;
+	if (tlb_range_is_all(curr))
+		goto skip;
+
+	if (tlb_range_is_all(next)) {
+		curr->start = 0;
+		curr->size  = SBI_TLB_FLUSH_ALL;
+		goto updated;
 	}
 
-	return ret;
+	next_end = tlb_range_end(next);
+	curr_end = tlb_range_end(curr);
+
+	/* Only merge overlapping or adjacent ranges */
+	if (next->start > curr_end || curr->start > next_end)
+		return SBI_FIFO_UNCHANGED;
+
+	if (next->start >= curr->start && next_end <= curr_end)
+		goto skip;
+
+	curr->start = MIN(curr->start, next->start);
+	curr->size  = MAX(curr_end, next_end) - curr->start;
+
+updated:
+	sbi_hartmask_or(&curr->smask, &curr->smask, &next->smask);
+	return SBI_FIFO_UPDATED;
+
+skip:
+	sbi_hartmask_or(&curr->smask, &curr->smask, &next->smask);
+	return SBI_FIFO_SKIP;
 }
 
 /**
  * Call back to decide if an inplace fifo update is required or next entry can
- * can be skipped. Here are the different cases that are being handled.
+ * can be skipped. Entries are only merged when their (type, vmid, asid) key
+ * matches. Here are the different cases that are being handled.
  *
  * Case1:
- *	if next flush request range lies within one of the existing entry, skip
- *	the next entry.
+ *	if next flush request range lies within one of the existing entry, or
+ *	the existing entry is a full flush or FENCE.I, skip the next entry.
  * Case2:
- *	if flush request range in current fifo entry lies within next flush
- *	request, update the current entry.
+ *	if next flush request range overlaps or is adjacent to the range in
+ *	current fifo entry, or next is a full flush, update the current entry
+ *	to cover both.
  *
  * Note:
  *	We can not issue a fifo reset anymore if a complete vma flush is requested.
@@ -308,24 +783,20 @@ static int tlb_update_cb(void *in, void *data)
 {
 	struct sbi_tlb_info *curr;
 	struct sbi_tlb_info *next;
-	int ret = SBI_FIFO_UNCHANGED;
 
 	if (!in || !data)
-		return ret;
+		return SBI_FIFO_UNCHANGED;
 
 	curr = (struct sbi_tlb_info *)data;
 	next = (struct sbi_tlb_info *)in;
 
-	if (next->type == SBI_TLB_SFENCE_VMA_ASID &&
-	    curr->type == SBI_TLB_SFENCE_VMA_ASID) {
-		if (next->asid == curr->asid)
-			ret = tlb_range_check(curr, next);
-	} else if (next->type == SBI_TLB_SFENCE_VMA &&
-		   curr->type == SBI_TLB_SFENCE_VMA) {
-		ret = tlb_range_check(curr, next);
-	}
+	/* Fields not used by a fence type are always zero */
+	if (next->type != curr->type ||
+	    next->vmid != curr->vmid ||
+	    next->asid != curr->asid)
+		return SBI_FIFO_UNCHANGED;
 
-	return ret;
+	return tlb_range_check(curr, next);
 }
 
 static int tlb_update(struct sbi_scratch *scratch,
@@ -334,7 +805,8 @@ static int tlb_update(struct sbi_scratch *scratch,
 {
 	int ret;
 	atomic_t *tlb_sync;
-	struct sbi_fifo *tlb_fifo_r;
+	struct sbi_mpsc_fifo *tlb_fifo_r;
+	struct sbi_tlb_coalesce_stats *stats;
 	struct sbi_tlb_info *tinfo = data;
 	u32 curr_hartid = current_hartid();
 
@@ -347,24 +819,34 @@ static int tlb_update(struct sbi_scratch *scratch,
 		return SBI_IPI_UPDATE_BREAK;
 	}
 
-	tlb_fifo_r = sbi_scratch_offset_ptr(remote_scratch, tlb_fifo_off);
+	/* Neither queue nor IPI a target which has already fenced */
+	if (tlb_fence_i_done(remote_scratch, tinfo)) {
+		stats = sbi_scratch_offset_ptr(scratch, tlb_stats_off);
+		stats->elided[tinfo->type]++;
+		return SBI_IPI_UPDATE_BREAK;
+	}
 
-	ret = sbi_fifo_inplace_update(tlb_fifo_r, data, tlb_update_cb);
+	tlb_fifo_r = sbi_scratch_offset_ptr(remote_scratch, tlb_fifo_off);
 
-	if (ret == SBI_FIFO_UNCHANGED &&
-	    sbi_fifo_enqueue(tlb_fifo_r, data, false) < 0) {
+	ret = sbi_mpsc_fifo_inplace_update(tlb_fifo_r, data, tlb_update_cb);
+	if (ret != SBI_FIFO_UNCHANGED) {
+		stats = sbi_scratch_offset_ptr(scratch, tlb_stats_off);
+		stats->merged[tinfo->type]++;
+	} else if (sbi_mpsc_fifo_enqueue(tlb_fifo_r, data) < 0) {
 		/**
-		 * For now, Busy loop until there is space in the fifo.
-		 * There may be case where target hart is also
-		 * enqueue in source hart's fifo. Both hart may busy
-		 * loop leading to a deadlock.
-		 * TODO: Introduce a wait/wakeup event mechanism to handle
-		 * this properly.
+		 * Retry until there is space in the fifo. The target hart
+		 * may also be enqueueing in our fifo, so drain our own
+		 * requests first to avoid a deadlock and only wait for the
+		 * target to free a slot when there was nothing to do.
 		 */
-		tlb_process_once(scratch);
+		if (!tlb_process_once(scratch))
+			sbi_mpsc_fifo_wait_space(tlb_fifo_r);
 		sbi_dprintf("hart%d: hart%d tlb fifo full\n", curr_hartid,
 			    sbi_hartindex_to_hartid(remote_hartindex));
 		return SBI_IPI_UPDATE_RETRY;
+	} else {
+		stats = sbi_scratch_offset_ptr(scratch, tlb_stats_off);
+		stats->queued[tinfo->type]++;
 	}
 
 	tlb_sync = sbi_scratch_offset_ptr(scratch, tlb_sync_off);
@@ -373,6 +855,73 @@ static int tlb_update(struct sbi_scratch *scratch,
 	return SBI_IPI_UPDATE_SUCCESS;
 }
 
+static int tlb_bcast_update(struct sbi_scratch *scratch,
+			    struct sbi_scratch *remote_scratch,
+			    u32 remote_hartindex, void *data)
+{
+	struct sbi_tlb_bcast *bcast = data;
+	struct sbi_tlb_coalesce_stats *stats;
+	struct sbi_hartmask *pend;
+
+	if (remote_scratch == scratch) {
+		tlb_entry_local_process(&bcast->info);
+		return SBI_IPI_UPDATE_BREAK;
+	}
+
+	if (tlb_fence_i_done(remote_scratch, &bcast->info)) {
+		stats = sbi_scratch_offset_ptr(scratch, tlb_stats_off);
+		stats->elided[bcast->info.type]++;
+		return SBI_IPI_UPDATE_BREAK;
+	}
+
+#ifdef CONFIG_SBI_TLB_TREE_FANOUT
+	/* Only collect the target, tlb_bcast_sync() starts the tree */
+	if (bcast->tree) {
+		sbi_hartmask_set_hartindex(remote_hartindex, &bcast->targets);
+		return SBI_IPI_UPDATE_BREAK;
+	}
+#endif
+
+	/*
+	 * The fully ordered add makes the descriptor visible before the
+	 * remote hart can observe our bit in its pending mask.
+	 */
+	atomic_add_return(&bcast->pending, 1);
+	pend = sbi_scratch_offset_ptr(remote_scratch, tlb_bcast_pend_off);
+	atomic_raw_set_bit(current_hartindex(), sbi_hartmask_bits(pend));
+
+	return SBI_IPI_UPDATE_SUCCESS;
+}
+
+static void tlb_bcast_sync(struct sbi_scratch *scratch)
+{
+	struct sbi_tlb_bcast *bcast =
+			sbi_scratch_offset_ptr(scratch, tlb_bcast_off);
+	long pending;
+
+#ifdef CONFIG_SBI_TLB_TREE_FANOUT
+	int count;
+
+	if (bcast->tree) {
+		count = sbi_hartmask_weight(&bcast->targets);
+		if (!count)
+			return;
+		/* Publish the descriptor and targets before notifying */
+		atomic_add_return(&bcast->pending, count);
+		tlb_bcast_relay(bcast, current_hartindex(), -1);
+	}
+#endif
+
+	while ((pending = atomic_read(&bcast->pending)) > 0) {
+		/*
+		 * While we are waiting for remote harts to acknowledge,
+		 * consume their requests to avoid deadlock.
+		 */
+		if (!tlb_process_once(scratch))
+			sbi_hart_wait_value(&bcast->pending.counter, pending);
+	}
+}
+
 static struct sbi_ipi_event_ops tlb_ops = {
 	.name = "IPI_TLB",
 	.update = tlb_update,
@@ -380,7 +929,12 @@ static struct sbi_ipi_event_ops tlb_ops = {
 	.process = tlb_process,
 };
 
-static u32 tlb_event = SBI_IPI_EVENT_MAX;
+static struct sbi_ipi_event_ops tlb_bcast_ops = {
+	.name = "IPI_TLB_BCAST",
+	.update = tlb_bcast_update,
+	.sync = tlb_bcast_sync,
+	.process = tlb_process,
+};
 
 static const u32 tlb_type_to_pmu_fw_event[SBI_TLB_TYPE_MAX] = {
 	[SBI_TLB_FENCE_I] = SBI_PMU_FW_FENCE_I_SENT,
@@ -394,30 +948,79 @@ static const u32 tlb_type_to_pmu_fw_event[SBI_TLB_TYPE_MAX] = {
 
 int sbi_tlb_request(ulong hmask, ulong hbase, struct sbi_tlb_info *tinfo)
 {
+	struct sbi_tlb_coalesce_stats *stats;
+	struct sbi_tlb_bcast *bcast;
+	unsigned long start_cycles;
+	int ret;
+
 	if (tinfo->type < 0 || tinfo->type >= SBI_TLB_TYPE_MAX)
 		return SBI_EINVAL;
 
 	/*
 	 * If address range to flush is too big then simply
 	 * upgrade it to flush all because we can only flush
-	 * 4KB at a time.
+	 * 4KB at a time. Target harts apply their own limit
+	 * as well, which may be lower than this one.
 	 */
-	if (tinfo->size > tlb_range_flush_limit) {
+	if (tinfo->size > tlb_request_flush_limit) {
 		tinfo->start = 0;
 		tinfo->size = SBI_TLB_FLUSH_ALL;
 	}
 
 	sbi_pmu_ctr_incr_fw(tlb_type_to_pmu_fw_event[tinfo->type]);
 
+	/*
+	 * The fully ordered increment also orders the instruction memory
+	 * updates done by the caller before the new epoch.
+	 */
+	if (tinfo->type == SBI_TLB_FENCE_I)
+		tinfo->epoch = atomic_add_return(&tlb_fence_i_epoch, 1);
+
+	/*
+	 * For wide requests, publish a single descriptor which every
+	 * target hart acknowledges instead of copying the request into
+	 * each target hart's fifo.
+	 */
+	if (hbase == -1UL || sbi_popcount(hmask) >= SBI_TLB_BCAST_MIN_TARGETS) {
+		stats = sbi_scratch_thishart_offset_ptr(tlb_stats_off);
+		stats->broadcast[tinfo->type]++;
+		bcast = sbi_scratch_thishart_offset_ptr(tlb_bcast_off);
+		sbi_memcpy(&bcast->info, tinfo, sizeof(*tinfo));
+		ATOMIC_INIT(&bcast->pending, 0);
+#ifdef CONFIG_SBI_TLB_TREE_FANOUT
+		bcast->tree = hbase == -1UL ||
+			      sbi_popcount(hmask) > TLB_TREE_DEGREE;
+		sbi_hartmask_clear_all(&bcast->targets);
+#endif
+		start_cycles = csr_read(CSR_MCYCLE);
+		ret = sbi_ipi_send_many(hmask, hbase, tlb_bcast_event, bcast);
+		stats->broadcast_cycles[tinfo->type] +=
+				csr_read(CSR_MCYCLE) - start_cycles;
+		return ret;
+	}
+
 	return sbi_ipi_send_many(hmask, hbase, tlb_event, tinfo);
 }
 
+const struct sbi_tlb_coalesce_stats *
+sbi_tlb_get_coalesce_stats(u32 hartindex)
+{
+	struct sbi_scratch *scratch = sbi_hartindex_to_scratch(hartindex);
+
+	if (!scratch || !tlb_stats_off)
+		return NULL;
+
+	return sbi_scratch_offset_ptr(scratch, tlb_stats_off);
+}
+
 int sbi_tlb_init(struct sbi_scratch *scratch, bool cold_boot)
 {
 	int ret;
 	void *tlb_mem;
 	atomic_t *tlb_sync;
-	struct sbi_fifo *tlb_q;
+	struct sbi_mpsc_fifo *tlb_q;
+	struct sbi_tlb_bcast *bcast;
+	struct sbi_hartmask *bcast_pend;
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
 
 	if (cold_boot) {
@@ -426,30 +1029,65 @@ int sbi_tlb_init(struct sbi_scratch *scratch, bool cold_boot)
 			return SBI_ENOMEM;
 		tlb_fifo_off = sbi_scratch_alloc_offset(sizeof(*tlb_q));
 		if (!tlb_fifo_off) {
-			sbi_scratch_free_offset(tlb_sync_off);
-			return SBI_ENOMEM;
+			ret = SBI_ENOMEM;
+			goto fail_free_sync;
 		}
 		tlb_fifo_mem_off = sbi_scratch_alloc_offset(sizeof(tlb_mem));
 		if (!tlb_fifo_mem_off) {
-			sbi_scratch_free_offset(tlb_fifo_off);
-			sbi_scratch_free_offset(tlb_sync_off);
-			return SBI_ENOMEM;
+			ret = SBI_ENOMEM;
+			goto fail_free_fifo;
 		}
-		ret = sbi_ipi_event_create(&tlb_ops);
-		if (ret < 0) {
-			sbi_scratch_free_offset(tlb_fifo_mem_off);
-			sbi_scratch_free_offset(tlb_fifo_off);
-			sbi_scratch_free_offset(tlb_sync_off);
-			return ret;
+		tlb_bcast_off = sbi_scratch_alloc_offset(sizeof(*bcast));
+		if (!tlb_bcast_off) {
+			ret = SBI_ENOMEM;
+			goto fail_free_fifo_mem;
+		}
+		tlb_bcast_pend_off = sbi_scratch_alloc_offset(sizeof(*bcast_pend));
+		if (!tlb_bcast_pend_off) {
+			ret = SBI_ENOMEM;
+			goto fail_free_bcast;
+		}
+		tlb_limits_off =
+			sbi_scratch_alloc_offset(sizeof(struct sbi_tlb_limits));
+		if (!tlb_limits_off) {
+			ret = SBI_ENOMEM;
+			goto fail_free_bcast_pend;
+		}
+		tlb_stats_off = sbi_scratch_alloc_offset(
+				sizeof(struct sbi_tlb_coalesce_stats));
+		if (!tlb_stats_off) {
+			ret = SBI_ENOMEM;
+			goto fail_free_limits;
+		}
+		tlb_fence_i_epoch_off = sbi_scratch_alloc_offset(sizeof(ulong));
+		if (!tlb_fence_i_epoch_off) {
+			ret = SBI_ENOMEM;
+			goto fail_free_stats;
 		}
+		ret = sbi_ipi_event_create(&tlb_ops);
+		if (ret < 0)
+			goto fail_free_epoch;
 		tlb_event = ret;
+		ret = sbi_ipi_event_create(&tlb_bcast_ops);
+		if (ret < 0)
+			goto fail_destroy_event;
+		tlb_bcast_event = ret;
 		tlb_range_flush_limit = sbi_platform_tlbr_flush_limit(plat);
+		tlb_svinval_flush_limit = MAX(tlb_range_flush_limit,
+					      TLB_SVINVAL_RANGE_FLUSH_LIMIT);
+		tlb_request_flush_limit = tlb_range_flush_limit;
 	} else {
 		if (!tlb_sync_off ||
 		    !tlb_fifo_off ||
-		    !tlb_fifo_mem_off)
+		    !tlb_fifo_mem_off ||
+		    !tlb_bcast_off ||
+		    !tlb_bcast_pend_off ||
+		    !tlb_limits_off ||
+		    !tlb_stats_off ||
+		    !tlb_fence_i_epoch_off)
 			return SBI_ENOMEM;
-		if (SBI_IPI_EVENT_MAX <= tlb_event)
+		if (SBI_IPI_EVENT_MAX <= tlb_event ||
+		    SBI_IPI_EVENT_MAX <= tlb_bcast_event)
 			return SBI_ENOSPC;
 	}
 
@@ -457,8 +1095,9 @@ int sbi_tlb_init(struct sbi_scratch *scratch, bool cold_boot)
 	tlb_q = sbi_scratch_offset_ptr(scratch, tlb_fifo_off);
 	tlb_mem = sbi_scratch_read_type(scratch, void *, tlb_fifo_mem_off);
 	if (!tlb_mem) {
-		tlb_mem = sbi_malloc(
-				sbi_platform_tlb_fifo_num_entries(plat) * SBI_TLB_INFO_SIZE);
+		tlb_mem = sbi_malloc(SBI_MPSC_FIFO_MEM_SIZE(
+				sbi_platform_tlb_fifo_num_entries(plat),
+				SBI_TLB_INFO_SIZE));
 		if (!tlb_mem)
 			return SBI_ENOMEM;
 		sbi_scratch_write_type(scratch, void *, tlb_fifo_mem_off, tlb_mem);
@@ -466,8 +1105,41 @@ int sbi_tlb_init(struct sbi_scratch *scratch, bool cold_boot)
 
 	ATOMIC_INIT(tlb_sync, 0);
 
-	sbi_fifo_init(tlb_q, tlb_mem,
-		      sbi_platform_tlb_fifo_num_entries(plat), SBI_TLB_INFO_SIZE);
+	tlb_limits_calibrate(scratch);
+
+	sbi_memset(sbi_scratch_offset_ptr(scratch, tlb_stats_off), 0,
+		   sizeof(struct sbi_tlb_coalesce_stats));
+	sbi_scratch_write_type(scratch, ulong, tlb_fence_i_epoch_off, 0);
+
+	bcast = sbi_scratch_offset_ptr(scratch, tlb_bcast_off);
+	ATOMIC_INIT(&bcast->pending, 0);
+	bcast_pend = sbi_scratch_offset_ptr(scratch, tlb_bcast_pend_off);
+	SBI_HARTMASK_INIT(bcast_pend);
+
+	sbi_mpsc_fifo_init(tlb_q, tlb_mem,
+			   sbi_platform_tlb_fifo_num_entries(plat),
+			   SBI_TLB_INFO_SIZE);
 
 	return 0;
+
+fail_destroy_event:
+	sbi_ipi_event_destroy(tlb_event);
+	tlb_event = SBI_IPI_EVENT_MAX;
+fail_free_epoch:
+	sbi_scratch_free_offset(tlb_fence_i_epoch_off);
+fail_free_stats:
+	sbi_scratch_free_offset(tlb_stats_off);
+fail_free_limits:
+	sbi_scratch_free_offset(tlb_limits_off);
+fail_free_bcast_pend:
+	sbi_scratch_free_offset(tlb_bcast_pend_off);
+fail_free_bcast:
+	sbi_scratch_free_offset(tlb_bcast_off);
+fail_free_fifo_mem:
+	sbi_scratch_free_offset(tlb_fifo_mem_off);
+fail_free_fifo:
+	sbi_scratch_free_offset(tlb_fifo_off);
+fail_free_sync:
+	sbi_scratch_free_offset(tlb_sync_off);
+	return ret;
 }
@@ -18,8 +18,10 @@
 #include <sbi/sbi_illegal_insn.h>
 #include <sbi/sbi_ipi.h>
 #include <sbi/sbi_irqchip.h>
+#include <sbi/sbi_latency.h>
 #include <sbi/sbi_trap_ldst.h>
 #include <sbi/sbi_pmu.h>
+#include <sbi/sbi_profile.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_sse.h>
 #include <sbi/sbi_timer.h>
@@ -228,6 +230,8 @@ int sbi_trap_redirect(struct sbi_trap_regs *regs,
 			regs->mstatus |= MSTATUS_SPELP;
 	}
 
+	sbi_latency_note_redirect();
+
 	return 0;
 }
 
@@ -309,6 +313,11 @@ struct sbi_trap_context *sbi_trap_handler(struct sbi_trap_context *tcntx)
 	const struct sbi_trap_info *trap = &tcntx->trap;
 	struct sbi_trap_regs *regs = &tcntx->regs;
 	ulong mcause = tcntx->trap.cause;
+	unsigned long start = sbi_latency_start();
+
+	/* Interrupt taken in a profiling window of M-mode code */
+	if (sbi_profile_sample(tcntx))
+		return tcntx;
 
 	/* Update trap context pointer */
 	tcntx->prev_context = sbi_trap_get_context(scratch);
@@ -372,6 +381,8 @@ trap_done:
 	if (sbi_mstatus_prev_mode(regs->mstatus) != PRV_M)
 		sbi_sse_process_pending_events(regs);
 
+	sbi_latency_trap_record(mcause, start);
+
 	sbi_trap_set_context(scratch, tcntx->prev_context);
 	return tcntx;
 }
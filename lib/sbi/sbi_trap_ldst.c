@@ -268,6 +268,55 @@ static int sbi_trap_emulate_store(struct sbi_trap_context *tcntx,
 	return 0;
 }
 
+static u64 sbi_misaligned_load_aligned(ulong addr, int len,
+				      struct sbi_trap_info *uptrap)
+{
+	switch (len) {
+	case 2:
+		return sbi_load_u16((const u16 *)addr, uptrap);
+	case 4:
+		return sbi_load_u32((const u32 *)addr, uptrap);
+	case 8:
+		return sbi_load_u64((const u64 *)addr, uptrap);
+	default:
+		return sbi_load_u8((const u8 *)addr, uptrap);
+	}
+}
+
+/*
+ * Emulate a misaligned load with the two naturally aligned loads covering
+ * it, merging the halves. Every unprivileged access switches MTVEC and
+ * MPRV so this is much cheaper than going byte by byte.
+ *
+ * @return true on success and false if any of the loads faulted
+ */
+static bool sbi_misaligned_ld_fast(int rlen, union sbi_ldst_data *out_val,
+				   ulong addr)
+{
+	ulong base = addr & ~((ulong)rlen - 1);
+	ulong shift = (addr - base) * 8;
+	struct sbi_trap_info uptrap;
+	u64 lo, hi, val;
+
+	if (rlen < 2 || rlen > sizeof(out_val->data_bytes) ||
+	    (rlen & (rlen - 1)) || !shift)
+		return false;
+
+	lo = sbi_misaligned_load_aligned(base, rlen, &uptrap);
+	if (uptrap.cause)
+		return false;
+	hi = sbi_misaligned_load_aligned(base + rlen, rlen, &uptrap);
+	if (uptrap.cause)
+		return false;
+
+	val = (lo >> shift) | (hi << (rlen * 8 - shift));
+	if (rlen < sizeof(val))
+		val &= (1ULL << (rlen * 8)) - 1;
+	out_val->data_u64 = val;
+
+	return true;
+}
+
 static int sbi_misaligned_ld_emulator(int rlen, union sbi_ldst_data *out_val,
 				      struct sbi_trap_context *tcntx)
 {
@@ -276,6 +325,14 @@ static int sbi_misaligned_ld_emulator(int rlen, union sbi_ldst_data *out_val,
 	struct sbi_trap_info uptrap;
 	int i;
 
+	if (sbi_misaligned_ld_fast(rlen, out_val, orig_trap->tval))
+		return rlen;
+
+	/*
+	 * One of the aligned loads faulted (e.g. the access crosses into
+	 * an unmapped page), go byte by byte so that the redirected trap
+	 * reports the exact faulting address.
+	 */
 	for (i = 0; i < rlen; i++) {
 		out_val->data_bytes[i] =
 			sbi_load_u8((void *)(orig_trap->tval + i), &uptrap);
@@ -293,17 +350,50 @@ int sbi_misaligned_load_handler(struct sbi_trap_context *tcntx)
 	return sbi_trap_emulate_load(tcntx, sbi_misaligned_ld_emulator);
 }
 
+/*
+ * Emulate a misaligned store with the largest naturally aligned stores
+ * fitting in it, so that at most four stores are needed for 8 bytes.
+ * Unlike loads, stores can't be merged into wider aligned accesses
+ * because a read-modify-write of the neighbouring bytes would race with
+ * other HARTs writing them.
+ */
 static int sbi_misaligned_st_emulator(int wlen, union sbi_ldst_data in_val,
 				      struct sbi_trap_context *tcntx)
 {
 	const struct sbi_trap_info *orig_trap = &tcntx->trap;
 	struct sbi_trap_regs *regs = &tcntx->regs;
 	struct sbi_trap_info uptrap;
-	int i;
+	ulong addr;
+	int i, n;
+
+	for (i = 0; i < wlen; i += n) {
+		addr = orig_trap->tval + i;
+		n = 1;
+		while (n < sizeof(ulong) && !(addr & (2 * n - 1)) &&
+		       i + 2 * n <= wlen)
+			n *= 2;
+
+		switch (n) {
+		case 8:
+#if __riscv_xlen == 64
+			sbi_store_u64((u64 *)addr, in_val.data_u64 >> (i * 8),
+				      &uptrap);
+			break;
+#endif
+		case 4:
+			sbi_store_u32((u32 *)addr, in_val.data_u64 >> (i * 8),
+				      &uptrap);
+			break;
+		case 2:
+			sbi_store_u16((u16 *)addr, in_val.data_u64 >> (i * 8),
+				      &uptrap);
+			break;
+		default:
+			sbi_store_u8((u8 *)addr, in_val.data_bytes[i], &uptrap);
+			break;
+		}
 
-	for (i = 0; i < wlen; i++) {
-		sbi_store_u8((void *)(orig_trap->tval + i),
-			     in_val.data_bytes[i], &uptrap);
+		/* An aligned chunk never crosses a page so it faults as a whole */
 		if (uptrap.cause) {
 			uptrap.tinst = sbi_misaligned_tinst_fixup(
 				orig_trap->tinst, uptrap.tinst, i);
@@ -21,6 +21,25 @@
 
 #define VLEN_MAX 65536
 
+/* Size of the buffer used to move runs of contiguous elements */
+#define VEC_CHUNK_BYTES 256
+
+/*
+ * Number of active elements starting at vstart which can be moved in one
+ * chunk, assuming the caller checked that they are contiguous in memory.
+ */
+static ulong vec_run_length(bool masked, const uint8_t *mask, ulong vstart,
+			    ulong vl, ulong elem_size)
+{
+	ulong run = 0, max = VEC_CHUNK_BYTES / elem_size;
+
+	while (vstart + run < vl && run < max &&
+	       (!masked || ((mask[(vstart + run) / 8] >> ((vstart + run) % 8)) & 1)))
+		run++;
+
+	return run;
+}
+
 static inline void set_vreg(ulong vlenb, ulong which,
 			    ulong pos, ulong size, const uint8_t *bytes)
 {
@@ -159,10 +178,13 @@ int sbi_misaligned_v_ld_emulator(int rlen, union sbi_ldst_data *out_val,
 	bool masked = IS_MASKED(insn);
 	uint8_t mask[VLEN_MAX / 8];
 	uint8_t bytes[8 * sizeof(uint64_t)];
+	uint8_t chunk[VEC_CHUNK_BYTES];
 	ulong len = GET_LEN(view);
 	ulong nf = GET_NF(insn);
 	ulong vemul = GET_VEMUL(vlmul, view, vsew);
 	ulong emul = GET_EMUL(vemul);
+	ulong run, i;
+	bool contig;
 
 	if (IS_UNIT_STRIDE_LOAD(insn) || IS_FAULT_ONLY_FIRST_LOAD(insn)) {
 		stride = nf * len;
@@ -190,11 +212,39 @@ int sbi_misaligned_v_ld_emulator(int rlen, union sbi_ldst_data *out_val,
 	if (masked)
 		get_vreg(vlenb, 0, 0, vlenb, mask);
 
+	/* Unit-stride, whole register and packed strided accesses */
+	contig = !IS_INDEXED_LOAD(insn) && stride == nf * len;
+
 	do {
 		if (!masked || ((mask[vstart / 8] >> (vstart % 8)) & 1)) {
 			/* compute element address */
 			ulong addr = base + vstart * stride;
 
+			/*
+			 * Load a run of contiguous elements in one go. On a
+			 * fault, go element by element to report the exact
+			 * faulting element and byte.
+			 */
+			run = contig ? vec_run_length(masked, mask, vstart, vl,
+						      nf * len) : 0;
+			if (run > 1) {
+				sbi_load_bytes(chunk, addr, run * nf * len, &uptrap);
+				if (!uptrap.cause) {
+					if (nf == 1) {
+						set_vreg(vlenb, vd, vstart * len,
+							 run * len, chunk);
+					} else {
+						for (i = 0; i < run; i++)
+							for (ulong seg = 0; seg < nf; seg++)
+								set_vreg(vlenb, vd + seg * emul,
+									 (vstart + i) * len, len,
+									 &chunk[(i * nf + seg) * len]);
+					}
+					vstart += run - 1;
+					continue;
+				}
+			}
+
 			if (IS_INDEXED_LOAD(insn)) {
 				ulong offset = 0;
 
@@ -259,10 +309,13 @@ int sbi_misaligned_v_st_emulator(int wlen, union sbi_ldst_data in_val,
 	bool masked = IS_MASKED(insn);
 	uint8_t mask[VLEN_MAX / 8];
 	uint8_t bytes[8 * sizeof(uint64_t)];
+	uint8_t chunk[VEC_CHUNK_BYTES];
 	ulong len = GET_LEN(view);
 	ulong nf = GET_NF(insn);
 	ulong vemul = GET_VEMUL(vlmul, view, vsew);
 	ulong emul = GET_EMUL(vemul);
+	ulong run, i;
+	bool contig;
 
 	if (IS_UNIT_STRIDE_STORE(insn)) {
 		stride = nf * len;
@@ -290,11 +343,39 @@ int sbi_misaligned_v_st_emulator(int wlen, union sbi_ldst_data in_val,
 	if (masked)
 		get_vreg(vlenb, 0, 0, vlenb, mask);
 
+	/* Unit-stride, whole register and packed strided accesses */
+	contig = !IS_INDEXED_STORE(insn) && stride == nf * len;
+
 	do {
 		if (!masked || ((mask[vstart / 8] >> (vstart % 8)) & 1)) {
 			/* compute element address */
 			ulong addr = base + vstart * stride;
 
+			/*
+			 * Store a run of contiguous elements in one go. On a
+			 * fault, redo the run element by element to report
+			 * the exact faulting element and byte.
+			 */
+			run = contig ? vec_run_length(masked, mask, vstart, vl,
+						      nf * len) : 0;
+			if (run > 1) {
+				if (nf == 1) {
+					get_vreg(vlenb, vd, vstart * len,
+						 run * len, chunk);
+				} else {
+					for (i = 0; i < run; i++)
+						for (ulong seg = 0; seg < nf; seg++)
+							get_vreg(vlenb, vd + seg * emul,
+								 (vstart + i) * len, len,
+								 &chunk[(i * nf + seg) * len]);
+				}
+				sbi_store_bytes(addr, chunk, run * nf * len, &uptrap);
+				if (!uptrap.cause) {
+					vstart += run - 1;
+					continue;
+				}
+			}
+
 			if (IS_INDEXED_STORE(insn)) {
 				ulong offset = 0;
 
@@ -7,10 +7,12 @@
  *   Anup Patel <anup.patel@wdc.com>
  */
 
+#include <sbi/riscv_asm.h>
 #include <sbi/riscv_encoding.h>
 #include <sbi/sbi_bitops.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
 #include <sbi/sbi_trap.h>
 #include <sbi/sbi_unpriv.h>
 
@@ -167,3 +169,183 @@ ulong sbi_get_insn(ulong mepc, struct sbi_trap_info *trap)
 
 	return insn;
 }
+
+/*
+ * Load up to SBI_UNPRIV_WINDOW_WORDS naturally aligned words within a
+ * single MTVEC/MPRV window. The expected trap handler clobbers a4, which
+ * is cleared before the window, so a non-zero a4 after an access means
+ * that it faulted and the window must be left before doing anything
+ * else.
+ */
+static void sbi_load_ulong_window(const ulong *addr, ulong count,
+				  ulong *vals, struct sbi_trap_info *trap)
+{
+	register ulong tinfo asm("a3");
+	register ulong ttmp asm("a4");
+	register ulong mstatus = 0;
+	register ulong mtvec = sbi_hart_expected_trap_addr();
+	ulong v0 = 0, v1 = 0, v2 = 0, v3 = 0;
+
+	trap->cause = 0;
+
+	asm volatile(
+	    "add %[tinfo], %[taddr], zero\n"
+	    "add %[ttmp], zero, zero\n"
+	    "csrrw %[mtvec], " STR(CSR_MTVEC) ", %[mtvec]\n"
+	    "csrrs %[mstatus], " STR(CSR_MSTATUS) ", %[mprv]\n"
+	    ".option push\n"
+	    ".option norvc\n"
+	    REG_L " %[v0], 0(%[addr])\n"
+	    "bne %[ttmp], zero, 2f\n"
+	    "addi %[count], %[count], -1\n"
+	    "beq %[count], zero, 2f\n"
+	    REG_L " %[v1], " SZREG "(%[addr])\n"
+	    "bne %[ttmp], zero, 2f\n"
+	    "addi %[count], %[count], -1\n"
+	    "beq %[count], zero, 2f\n"
+	    "addi %[addr], %[addr], 2 * " SZREG "\n"
+	    REG_L " %[v2], 0(%[addr])\n"
+	    "bne %[ttmp], zero, 2f\n"
+	    "addi %[count], %[count], -1\n"
+	    "beq %[count], zero, 2f\n"
+	    REG_L " %[v3], " SZREG "(%[addr])\n"
+	    ".option pop\n"
+	    "2: csrw " STR(CSR_MSTATUS) ", %[mstatus]\n"
+	    "csrw " STR(CSR_MTVEC) ", %[mtvec]"
+	    : [mstatus] "+&r"(mstatus), [mtvec] "+&r"(mtvec),
+	      [tinfo] "+&r"(tinfo), [ttmp] "+&r"(ttmp),
+	      [addr] "+&r"(addr), [count] "+&r"(count),
+	      [v0] "+&r"(v0), [v1] "+&r"(v1), [v2] "+&r"(v2), [v3] "+&r"(v3)
+	    : [mprv] "r"(MSTATUS_MPRV), [taddr] "r"((ulong)trap)
+	    : "memory");
+
+	vals[0] = v0;
+	vals[1] = v1;
+	vals[2] = v2;
+	vals[3] = v3;
+}
+
+/* Store counterpart of sbi_load_ulong_window() */
+static void sbi_store_ulong_window(ulong *addr, ulong count,
+				   const ulong *vals, struct sbi_trap_info *trap)
+{
+	register ulong tinfo asm("a3");
+	register ulong ttmp asm("a4");
+	register ulong mstatus = 0;
+	register ulong mtvec = sbi_hart_expected_trap_addr();
+
+	trap->cause = 0;
+
+	asm volatile(
+	    "add %[tinfo], %[taddr], zero\n"
+	    "add %[ttmp], zero, zero\n"
+	    "csrrw %[mtvec], " STR(CSR_MTVEC) ", %[mtvec]\n"
+	    "csrrs %[mstatus], " STR(CSR_MSTATUS) ", %[mprv]\n"
+	    ".option push\n"
+	    ".option norvc\n"
+	    REG_S " %[v0], 0(%[addr])\n"
+	    "bne %[ttmp], zero, 2f\n"
+	    "addi %[count], %[count], -1\n"
+	    "beq %[count], zero, 2f\n"
+	    REG_S " %[v1], " SZREG "(%[addr])\n"
+	    "bne %[ttmp], zero, 2f\n"
+	    "addi %[count], %[count], -1\n"
+	    "beq %[count], zero, 2f\n"
+	    "addi %[addr], %[addr], 2 * " SZREG "\n"
+	    REG_S " %[v2], 0(%[addr])\n"
+	    "bne %[ttmp], zero, 2f\n"
+	    "addi %[count], %[count], -1\n"
+	    "beq %[count], zero, 2f\n"
+	    REG_S " %[v3], " SZREG "(%[addr])\n"
+	    ".option pop\n"
+	    "2: csrw " STR(CSR_MSTATUS) ", %[mstatus]\n"
+	    "csrw " STR(CSR_MTVEC) ", %[mtvec]"
+	    : [mstatus] "+&r"(mstatus), [mtvec] "+&r"(mtvec),
+	      [tinfo] "+&r"(tinfo), [ttmp] "+&r"(ttmp),
+	      [addr] "+&r"(addr), [count] "+&r"(count)
+	    : [mprv] "r"(MSTATUS_MPRV), [taddr] "r"((ulong)trap),
+	      [v0] "r"(vals[0]), [v1] "r"(vals[1]),
+	      [v2] "r"(vals[2]), [v3] "r"(vals[3])
+	    : "memory");
+}
+
+/**
+ * Copy len bytes from unprivileged memory at addr to dst, moving whole
+ * aligned words several at a time through one MPRV window.
+ *
+ * On a fault trap->cause is set and the copy stops, possibly before the
+ * faulting byte, so callers needing the exact faulting address have to
+ * retry byte by byte.
+ */
+void sbi_load_bytes(u8 *dst, ulong addr, ulong len,
+		    struct sbi_trap_info *trap)
+{
+	ulong vals[SBI_UNPRIV_WINDOW_WORDS], n;
+
+	trap->cause = 0;
+
+	while (len && (addr & (sizeof(ulong) - 1))) {
+		*dst++ = sbi_load_u8((const u8 *)addr++, trap);
+		if (trap->cause)
+			return;
+		len--;
+	}
+
+	while (len >= sizeof(ulong)) {
+		n = MIN(len / sizeof(ulong), (ulong)SBI_UNPRIV_WINDOW_WORDS);
+		sbi_load_ulong_window((const ulong *)addr, n, vals, trap);
+		if (trap->cause)
+			return;
+		sbi_memcpy(dst, vals, n * sizeof(ulong));
+		dst += n * sizeof(ulong);
+		addr += n * sizeof(ulong);
+		len -= n * sizeof(ulong);
+	}
+
+	while (len) {
+		*dst++ = sbi_load_u8((const u8 *)addr++, trap);
+		if (trap->cause)
+			return;
+		len--;
+	}
+}
+
+/**
+ * Copy len bytes from src to unprivileged memory at addr, moving whole
+ * aligned words several at a time through one MPRV window.
+ *
+ * On a fault trap->cause is set and the copy stops. Bytes before the
+ * faulting word may already have been written.
+ */
+void sbi_store_bytes(ulong addr, const u8 *src, ulong len,
+		     struct sbi_trap_info *trap)
+{
+	ulong vals[SBI_UNPRIV_WINDOW_WORDS], n;
+
+	trap->cause = 0;
+
+	while (len && (addr & (sizeof(ulong) - 1))) {
+		sbi_store_u8((u8 *)addr++, *src++, trap);
+		if (trap->cause)
+			return;
+		len--;
+	}
+
+	while (len >= sizeof(ulong)) {
+		n = MIN(len / sizeof(ulong), (ulong)SBI_UNPRIV_WINDOW_WORDS);
+		sbi_memcpy(vals, src, n * sizeof(ulong));
+		sbi_store_ulong_window((ulong *)addr, n, vals, trap);
+		if (trap->cause)
+			return;
+		src += n * sizeof(ulong);
+		addr += n * sizeof(ulong);
+		len -= n * sizeof(ulong);
+	}
+
+	while (len) {
+		sbi_store_u8((u8 *)addr++, *src++, trap);
+		if (trap->cause)
+			return;
+		len--;
+	}
+}
@@ -1,5 +1,6 @@
 libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_unit_test.o
 libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_unit_tests.carray.o
+libsbi-objs-$(CONFIG_SBIUNIT_BENCH) += tests/sbi_unit_benches.carray.o
 
 carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += bitmap_test_suite
 libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_bitmap_test.o
@@ -21,3 +22,20 @@ libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_ecall_test.o
 
 carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += bitops_test_suite
 libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_bitops_test.o
+
+carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += mpsc_fifo_test_suite
+carray-sbi_unit_benches-$(CONFIG_SBIUNIT_BENCH) += fifo_bench
+carray-sbi_unit_benches-$(CONFIG_SBIUNIT_BENCH) += mpsc_fifo_bench
+libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_mpsc_fifo_test.o
+
+carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += hartid_map_test_suite
+carray-sbi_unit_benches-$(CONFIG_SBIUNIT_BENCH) += hartid_scan_bench
+carray-sbi_unit_benches-$(CONFIG_SBIUNIT_BENCH) += hartid_map_bench
+libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_hartid_map_test.o
+
+carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += timer_test_suite
+libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_timer_test.o
+
+carray-sbi_unit_tests-$(CONFIG_SBIUNIT) += heap_test_suite
+carray-sbi_unit_benches-$(CONFIG_SBIUNIT_BENCH) += heap_bench
+libsbi-objs-$(CONFIG_SBIUNIT) += tests/sbi_heap_test.o
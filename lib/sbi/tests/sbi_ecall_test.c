@@ -40,10 +40,65 @@ static void test_sbi_ecall_register_find_extension(struct sbiunit_test_case *tes
 	SBIUNIT_EXPECT_EQ(test, sbi_ecall_find_extension(SBI_EXT_EXPERIMENTAL_START), NULL);
 }
 
+static void test_sbi_ecall_register_find_range(struct sbiunit_test_case *test)
+{
+	struct sbi_ecall_extension test_ext = {
+		.extid_start = SBI_EXT_EXPERIMENTAL_START + 0x10,
+		.extid_end = SBI_EXT_EXPERIMENTAL_START + 0x1f,
+		.name = "TestRng",
+		.handle = dummy_handler,
+	};
+
+	SBIUNIT_EXPECT_EQ(test, sbi_ecall_register_extension(&test_ext), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_ecall_find_extension(test_ext.extid_start), &test_ext);
+	SBIUNIT_EXPECT_EQ(test, sbi_ecall_find_extension(test_ext.extid_start + 7), &test_ext);
+	SBIUNIT_EXPECT_EQ(test, sbi_ecall_find_extension(test_ext.extid_end), &test_ext);
+	SBIUNIT_EXPECT_EQ(test, sbi_ecall_find_extension(test_ext.extid_end + 1), NULL);
+	SBIUNIT_EXPECT_EQ(test, sbi_ecall_find_extension(test_ext.extid_start - 1), NULL);
+
+	sbi_ecall_unregister_extension(&test_ext);
+	SBIUNIT_EXPECT_EQ(test, sbi_ecall_find_extension(test_ext.extid_start + 7), NULL);
+
+	/* Base extension must be found whatever else was registered */
+	SBIUNIT_EXPECT_NE(test, sbi_ecall_find_extension(SBI_EXT_BASE), NULL);
+}
+
+#define TEST_MANY_EXTS	72
+
+/* More extensions than the lookup table holds, lookups use the list */
+static void test_sbi_ecall_register_many(struct sbiunit_test_case *test)
+{
+	static struct sbi_ecall_extension exts[TEST_MANY_EXTS];
+	unsigned long i;
+
+	for (i = 0; i < TEST_MANY_EXTS; i++) {
+		exts[i].extid_start = SBI_EXT_EXPERIMENTAL_START + 0x100 + i;
+		exts[i].extid_end = exts[i].extid_start;
+		sbi_strncpy(exts[i].name, "TestMny", sizeof(exts[i].name));
+		exts[i].handle = dummy_handler;
+		SBIUNIT_EXPECT_EQ(test, sbi_ecall_register_extension(&exts[i]), 0);
+	}
+
+	for (i = 0; i < TEST_MANY_EXTS; i++)
+		SBIUNIT_EXPECT_EQ(test, sbi_ecall_find_extension(exts[i].extid_start),
+				  &exts[i]);
+	SBIUNIT_EXPECT_NE(test, sbi_ecall_find_extension(SBI_EXT_BASE), NULL);
+
+	for (i = 0; i < TEST_MANY_EXTS; i++)
+		sbi_ecall_unregister_extension(&exts[i]);
+
+	for (i = 0; i < TEST_MANY_EXTS; i++)
+		SBIUNIT_EXPECT_EQ(test, sbi_ecall_find_extension(exts[i].extid_start),
+				  NULL);
+	SBIUNIT_EXPECT_NE(test, sbi_ecall_find_extension(SBI_EXT_BASE), NULL);
+}
+
 static struct sbiunit_test_case ecall_tests[] = {
 	SBIUNIT_TEST_CASE(test_sbi_ecall_version),
 	SBIUNIT_TEST_CASE(test_sbi_ecall_impid),
 	SBIUNIT_TEST_CASE(test_sbi_ecall_register_find_extension),
+	SBIUNIT_TEST_CASE(test_sbi_ecall_register_find_range),
+	SBIUNIT_TEST_CASE(test_sbi_ecall_register_many),
 	SBIUNIT_END_CASE,
 };
 
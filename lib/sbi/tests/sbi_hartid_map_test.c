@@ -0,0 +1,137 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_unit_test.h>
+
+#define TEST_HARTS		SBI_HARTMASK_MAX_BITS
+
+static struct sbi_hartid_map test_map;
+static u32 test_hartids[TEST_HARTS];
+
+/* Clusters of 8 harts with the cluster number in bits [15:8] */
+static u32 cluster_hartid(u32 i)
+{
+	return ((i / 8) << 8) | (i % 8);
+}
+
+/* Scattered 32-bit HART ids which collide in the low bits */
+static u32 scattered_hartid(u32 i)
+{
+	return 0x80000000U | (i << 12);
+}
+
+static void hartid_map_check(struct sbiunit_test_case *test, u32 count)
+{
+	u32 i;
+
+	for (i = 0; i < count; i++)
+		SBIUNIT_EXPECT_EQ(test, sbi_hartid_map_lookup(&test_map,
+							      test_hartids[i]),
+				  i);
+}
+
+static void hartid_map_dense_test(struct sbiunit_test_case *test)
+{
+	u32 i;
+
+	for (i = 0; i < TEST_HARTS; i++)
+		test_hartids[i] = i;
+
+	SBIUNIT_ASSERT_EQ(test, sbi_hartid_map_build(&test_map, test_hartids,
+						     TEST_HARTS), 0);
+	SBIUNIT_EXPECT(test, test_map.direct);
+	hartid_map_check(test, TEST_HARTS);
+	SBIUNIT_EXPECT_EQ(test, sbi_hartid_map_lookup(&test_map, TEST_HARTS),
+			  -1U);
+	SBIUNIT_EXPECT_EQ(test, sbi_hartid_map_lookup(&test_map, -1U), -1U);
+}
+
+static void hartid_map_sparse_test(struct sbiunit_test_case *test)
+{
+	u32 i;
+
+	for (i = 0; i < TEST_HARTS; i++)
+		test_hartids[i] = cluster_hartid(i);
+
+	SBIUNIT_ASSERT_EQ(test, sbi_hartid_map_build(&test_map, test_hartids,
+						     TEST_HARTS), 0);
+	SBIUNIT_EXPECT(test, !test_map.direct);
+	hartid_map_check(test, TEST_HARTS);
+	SBIUNIT_EXPECT_EQ(test, sbi_hartid_map_lookup(&test_map, 0x8), -1U);
+
+	for (i = 0; i < TEST_HARTS; i++)
+		test_hartids[i] = scattered_hartid(i);
+
+	SBIUNIT_ASSERT_EQ(test, sbi_hartid_map_build(&test_map, test_hartids,
+						     TEST_HARTS), 0);
+	hartid_map_check(test, TEST_HARTS);
+	SBIUNIT_EXPECT_EQ(test, sbi_hartid_map_lookup(&test_map, 0x80000001U),
+			  -1U);
+	SBIUNIT_EXPECT_EQ(test, sbi_hartid_map_lookup(&test_map, 0), -1U);
+
+	/* A duplicate HART id keeps its first HART index */
+	test_hartids[1] = test_hartids[0];
+	SBIUNIT_ASSERT_EQ(test, sbi_hartid_map_build(&test_map, test_hartids,
+						     2), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_hartid_map_lookup(&test_map,
+						      test_hartids[0]), 0);
+}
+
+static void hartid_map_platform_test(struct sbiunit_test_case *test)
+{
+	sbi_for_each_hartindex(i)
+		SBIUNIT_EXPECT_EQ(test, sbi_hartid_to_hartindex(
+					sbi_hartindex_to_hartid(i)), i);
+}
+
+static struct sbiunit_test_case hartid_map_test_cases[] = {
+	SBIUNIT_TEST_CASE(hartid_map_dense_test),
+	SBIUNIT_TEST_CASE(hartid_map_sparse_test),
+	SBIUNIT_TEST_CASE(hartid_map_platform_test),
+	SBIUNIT_END_CASE,
+};
+
+SBIUNIT_TEST_SUITE(hartid_map_test_suite, hartid_map_test_cases);
+
+#ifdef CONFIG_SBIUNIT_BENCH
+static volatile u32 hartid_bench_sink;
+
+/* Compare against the linear scan used before for a sparse layout */
+static void hartid_bench_init(void)
+{
+	u32 i;
+
+	for (i = 0; i < TEST_HARTS; i++)
+		test_hartids[i] = cluster_hartid(i);
+	sbi_hartid_map_build(&test_map, test_hartids, TEST_HARTS);
+}
+
+static void hartid_scan_bench_run(unsigned long rounds)
+{
+	unsigned long r;
+	u32 i, hartid;
+
+	for (r = 0; r < rounds; r++) {
+		hartid = test_hartids[r % TEST_HARTS];
+		for (i = 0; i < TEST_HARTS; i++)
+			if (test_hartids[i] == hartid)
+				break;
+		hartid_bench_sink = i;
+	}
+}
+
+SBIUNIT_BENCH(hartid_scan_bench, hartid_bench_init, hartid_scan_bench_run);
+
+static void hartid_map_bench_run(unsigned long rounds)
+{
+	unsigned long r;
+
+	for (r = 0; r < rounds; r++)
+		hartid_bench_sink = sbi_hartid_map_lookup(&test_map,
+						test_hartids[r % TEST_HARTS]);
+}
+
+SBIUNIT_BENCH(hartid_map_bench, hartid_bench_init, hartid_map_bench_run);
+#endif
@@ -0,0 +1,196 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_unit_test.h>
+
+#define TEST_HEAP_SIZE		0x10000
+#define TEST_SLOTS		32
+#define TEST_MAX_SIZE		1024
+#define TEST_STRESS_ROUNDS	2048
+
+/* Upper bound of memory kept by the slab caches once everything is freed */
+#define TEST_SLAB_RETAINED	(4 * (2048 + 64))
+
+static char test_heap_mem[TEST_HEAP_SIZE] __aligned(1024);
+
+static struct sbi_heap_control *test_heap_new(void)
+{
+	struct sbi_heap_control *hpctrl = NULL;
+
+	sbi_heap_alloc_new(&hpctrl);
+	if (!hpctrl)
+		return NULL;
+	if (sbi_heap_init_new(hpctrl, (unsigned long)test_heap_mem,
+			      TEST_HEAP_SIZE)) {
+		sbi_free(hpctrl);
+		return NULL;
+	}
+
+	return hpctrl;
+}
+
+static unsigned long test_rand(unsigned long *state)
+{
+	*state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return *state >> 33;
+}
+
+static bool test_check_fill(const char *ptr, size_t size, char val)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		if (ptr[i] != val)
+			return false;
+	}
+
+	return true;
+}
+
+static void heap_size_class_test(struct sbiunit_test_case *test)
+{
+	static const size_t sizes[] = { 1, 64, 65, 128, 200, 256, 300, 512,
+					513, 1024 };
+	struct sbi_heap_control *hpctrl = test_heap_new();
+	char *ptrs[array_size(sizes)];
+	unsigned long i, before;
+
+	SBIUNIT_ASSERT(test, hpctrl);
+	before = sbi_heap_free_space_from(hpctrl);
+
+	for (i = 0; i < array_size(sizes); i++) {
+		ptrs[i] = sbi_malloc_from(hpctrl, sizes[i]);
+		SBIUNIT_ASSERT(test, ptrs[i]);
+		SBIUNIT_EXPECT(test, !((unsigned long)ptrs[i] & 63));
+		sbi_memset(ptrs[i], (char)i, sizes[i]);
+	}
+
+	/* No allocation may have overwritten another one */
+	for (i = 0; i < array_size(sizes); i++)
+		SBIUNIT_EXPECT(test, test_check_fill(ptrs[i], sizes[i], (char)i));
+
+	/* Free in an order different from allocation */
+	for (i = 0; i < array_size(sizes); i += 2)
+		sbi_free_from(hpctrl, ptrs[i]);
+	for (i = 1; i < array_size(sizes); i += 2)
+		sbi_free_from(hpctrl, ptrs[i]);
+
+	SBIUNIT_EXPECT(test, sbi_heap_free_space_from(hpctrl) +
+			     TEST_SLAB_RETAINED >= before);
+	sbi_free(hpctrl);
+}
+
+static void heap_aligned_test(struct sbiunit_test_case *test)
+{
+	struct sbi_heap_control *hpctrl = test_heap_new();
+	unsigned long align;
+	void *ptr;
+
+	SBIUNIT_ASSERT(test, hpctrl);
+
+	for (align = 64; align <= 2048; align <<= 1) {
+		ptr = sbi_aligned_alloc_from(hpctrl, align, align);
+		SBIUNIT_ASSERT(test, ptr);
+		SBIUNIT_EXPECT(test, !((unsigned long)ptr & (align - 1)));
+		sbi_free_from(hpctrl, ptr);
+
+		/* Small size with a large alignment */
+		ptr = sbi_aligned_alloc_from(hpctrl, align, 64);
+		if (align > 64) {
+			SBIUNIT_EXPECT(test, !ptr);
+		} else {
+			SBIUNIT_ASSERT(test, ptr);
+			sbi_free_from(hpctrl, ptr);
+		}
+	}
+
+	sbi_free(hpctrl);
+}
+
+/*
+ * Random mix of allocations and frees across slab and non-slab sizes,
+ * checking every live allocation keeps its contents.
+ */
+static void heap_stress_test(struct sbiunit_test_case *test)
+{
+	struct sbi_heap_control *hpctrl = test_heap_new();
+	size_t sizes[TEST_SLOTS] = { 0 };
+	char *ptrs[TEST_SLOTS] = { 0 };
+	unsigned long i, slot, seed = 1, before;
+	bool intact = true;
+
+	SBIUNIT_ASSERT(test, hpctrl);
+	before = sbi_heap_free_space_from(hpctrl);
+
+	for (i = 0; i < TEST_STRESS_ROUNDS; i++) {
+		slot = test_rand(&seed) % TEST_SLOTS;
+		if (ptrs[slot]) {
+			if (!test_check_fill(ptrs[slot], sizes[slot], (char)slot))
+				intact = false;
+			sbi_free_from(hpctrl, ptrs[slot]);
+			ptrs[slot] = NULL;
+		} else {
+			sizes[slot] = 1 + test_rand(&seed) % TEST_MAX_SIZE;
+			ptrs[slot] = sbi_malloc_from(hpctrl, sizes[slot]);
+			/* Running out of the small test heap is not an error */
+			if (ptrs[slot])
+				sbi_memset(ptrs[slot], (char)slot, sizes[slot]);
+		}
+	}
+
+	for (slot = 0; slot < TEST_SLOTS; slot++) {
+		if (!ptrs[slot])
+			continue;
+		if (!test_check_fill(ptrs[slot], sizes[slot], (char)slot))
+			intact = false;
+		sbi_free_from(hpctrl, ptrs[slot]);
+	}
+
+	SBIUNIT_EXPECT(test, intact);
+	SBIUNIT_EXPECT(test, sbi_heap_free_space_from(hpctrl) +
+			     TEST_SLAB_RETAINED >= before);
+	sbi_free(hpctrl);
+}
+
+static struct sbiunit_test_case heap_test_cases[] = {
+	SBIUNIT_TEST_CASE(heap_size_class_test),
+	SBIUNIT_TEST_CASE(heap_aligned_test),
+	SBIUNIT_TEST_CASE(heap_stress_test),
+	SBIUNIT_END_CASE,
+};
+
+SBIUNIT_TEST_SUITE(heap_test_suite, heap_test_cases);
+
+#ifdef CONFIG_SBIUNIT_BENCH
+static struct sbi_heap_control *heap_bench_hpctrl;
+
+static void heap_bench_init(void)
+{
+	if (!heap_bench_hpctrl)
+		heap_bench_hpctrl = test_heap_new();
+}
+
+/* Allocate and free pairs of the sizes seen most at boot */
+static void heap_bench_run(unsigned long rounds)
+{
+	static const size_t sizes[] = { 48, 64, 128, 200, 512, 1024 };
+	void *a, *b;
+	unsigned long r;
+
+	if (!heap_bench_hpctrl)
+		return;
+
+	for (r = 0; r < rounds; r++) {
+		a = sbi_malloc_from(heap_bench_hpctrl,
+				    sizes[r % array_size(sizes)]);
+		b = sbi_malloc_from(heap_bench_hpctrl,
+				    sizes[(r + 1) % array_size(sizes)]);
+		sbi_free_from(heap_bench_hpctrl, a);
+		sbi_free_from(heap_bench_hpctrl, b);
+	}
+}
+
+SBIUNIT_BENCH(heap_bench, heap_bench_init, heap_bench_run);
+#endif
@@ -0,0 +1,164 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_fifo.h>
+#include <sbi/sbi_mpsc_fifo.h>
+#include <sbi/sbi_unit_test.h>
+
+#define TEST_ENTRIES		8
+
+struct test_entry {
+	unsigned long start;
+	unsigned long size;
+};
+
+static char test_mem[SBI_MPSC_FIFO_MEM_SIZE(TEST_ENTRIES,
+					     sizeof(struct test_entry))]
+	__aligned(sizeof(unsigned long));
+static struct sbi_mpsc_fifo test_fifo;
+
+static int test_merge_cb(void *in, void *data)
+{
+	struct test_entry *next = in, *curr = data;
+
+	if (next->start != curr->start + curr->size)
+		return SBI_FIFO_UNCHANGED;
+
+	curr->size += next->size;
+	return SBI_FIFO_SKIP;
+}
+
+static void mpsc_fifo_order_test(struct sbiunit_test_case *test)
+{
+	struct test_entry e;
+	unsigned long i;
+
+	sbi_mpsc_fifo_init(&test_fifo, test_mem, TEST_ENTRIES, sizeof(e));
+	SBIUNIT_EXPECT(test, sbi_mpsc_fifo_is_empty(&test_fifo));
+	SBIUNIT_EXPECT_EQ(test, sbi_mpsc_fifo_dequeue(&test_fifo, &e), SBI_ENOENT);
+
+	/* Go around the ring a few times to cover wrap of sequence numbers */
+	for (i = 0; i < 3 * TEST_ENTRIES; i++) {
+		e.start = i;
+		e.size = i * 2;
+		SBIUNIT_ASSERT_EQ(test, sbi_mpsc_fifo_enqueue(&test_fifo, &e), 0);
+		e.start = e.size = 0;
+		SBIUNIT_ASSERT_EQ(test, sbi_mpsc_fifo_dequeue(&test_fifo, &e), 0);
+		SBIUNIT_EXPECT_EQ(test, e.start, i);
+		SBIUNIT_EXPECT_EQ(test, e.size, i * 2);
+	}
+
+	SBIUNIT_EXPECT(test, sbi_mpsc_fifo_is_empty(&test_fifo));
+}
+
+static void mpsc_fifo_full_test(struct sbiunit_test_case *test)
+{
+	struct test_entry e = { 0 };
+	unsigned long i;
+
+	sbi_mpsc_fifo_init(&test_fifo, test_mem, TEST_ENTRIES, sizeof(e));
+
+	for (i = 0; i < TEST_ENTRIES; i++) {
+		e.start = i;
+		SBIUNIT_ASSERT_EQ(test, sbi_mpsc_fifo_enqueue(&test_fifo, &e), 0);
+	}
+	SBIUNIT_EXPECT_EQ(test, sbi_mpsc_fifo_enqueue(&test_fifo, &e), SBI_ENOSPC);
+
+	/* Freeing one slot makes room for exactly one more entry */
+	SBIUNIT_ASSERT_EQ(test, sbi_mpsc_fifo_dequeue(&test_fifo, &e), 0);
+	SBIUNIT_EXPECT_EQ(test, e.start, 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_mpsc_fifo_enqueue(&test_fifo, &e), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_mpsc_fifo_enqueue(&test_fifo, &e), SBI_ENOSPC);
+
+	for (i = 1; i < TEST_ENTRIES; i++) {
+		SBIUNIT_ASSERT_EQ(test, sbi_mpsc_fifo_dequeue(&test_fifo, &e), 0);
+		SBIUNIT_EXPECT_EQ(test, e.start, i);
+	}
+	SBIUNIT_ASSERT_EQ(test, sbi_mpsc_fifo_dequeue(&test_fifo, &e), 0);
+	SBIUNIT_EXPECT_EQ(test, e.start, 0);
+	SBIUNIT_EXPECT(test, sbi_mpsc_fifo_is_empty(&test_fifo));
+}
+
+static void mpsc_fifo_inplace_update_test(struct sbiunit_test_case *test)
+{
+	struct test_entry e = { .start = 0x1000, .size = 0x1000 };
+
+	sbi_mpsc_fifo_init(&test_fifo, test_mem, TEST_ENTRIES, sizeof(e));
+
+	SBIUNIT_EXPECT_EQ(test, sbi_mpsc_fifo_inplace_update(&test_fifo, &e,
+							     test_merge_cb),
+			  SBI_FIFO_UNCHANGED);
+	SBIUNIT_ASSERT_EQ(test, sbi_mpsc_fifo_enqueue(&test_fifo, &e), 0);
+
+	e.start = 0x2000;
+	SBIUNIT_EXPECT_EQ(test, sbi_mpsc_fifo_inplace_update(&test_fifo, &e,
+							     test_merge_cb),
+			  SBI_FIFO_SKIP);
+
+	e.start = 0x8000;
+	SBIUNIT_EXPECT_EQ(test, sbi_mpsc_fifo_inplace_update(&test_fifo, &e,
+							     test_merge_cb),
+			  SBI_FIFO_UNCHANGED);
+
+	SBIUNIT_ASSERT_EQ(test, sbi_mpsc_fifo_dequeue(&test_fifo, &e), 0);
+	SBIUNIT_EXPECT_EQ(test, e.start, 0x1000);
+	SBIUNIT_EXPECT_EQ(test, e.size, 0x2000);
+	SBIUNIT_EXPECT(test, sbi_mpsc_fifo_is_empty(&test_fifo));
+}
+
+static struct sbiunit_test_case mpsc_fifo_test_cases[] = {
+	SBIUNIT_TEST_CASE(mpsc_fifo_order_test),
+	SBIUNIT_TEST_CASE(mpsc_fifo_full_test),
+	SBIUNIT_TEST_CASE(mpsc_fifo_inplace_update_test),
+	SBIUNIT_END_CASE,
+};
+
+SBIUNIT_TEST_SUITE(mpsc_fifo_test_suite, mpsc_fifo_test_cases);
+
+#ifdef CONFIG_SBIUNIT_BENCH
+static struct test_entry test_fifo_mem[TEST_ENTRIES];
+static struct sbi_fifo test_spin_fifo;
+
+/*
+ * SBIUnit runs on the boot HART only, so these compare the uncontended
+ * enqueue/dequeue cost of both FIFO flavours rather than a contended mix.
+ */
+static void fifo_bench_init(void)
+{
+	sbi_fifo_init(&test_spin_fifo, test_fifo_mem, TEST_ENTRIES,
+		      sizeof(struct test_entry));
+}
+
+static void fifo_bench_run(unsigned long rounds)
+{
+	struct test_entry e = { 0 };
+	unsigned long i;
+
+	for (i = 0; i < rounds; i++) {
+		sbi_fifo_enqueue(&test_spin_fifo, &e, false);
+		sbi_fifo_dequeue(&test_spin_fifo, &e);
+	}
+}
+
+SBIUNIT_BENCH(fifo_bench, fifo_bench_init, fifo_bench_run);
+
+static void mpsc_fifo_bench_init(void)
+{
+	sbi_mpsc_fifo_init(&test_fifo, test_mem, TEST_ENTRIES,
+			   sizeof(struct test_entry));
+}
+
+static void mpsc_fifo_bench_run(unsigned long rounds)
+{
+	struct test_entry e = { 0 };
+	unsigned long i;
+
+	for (i = 0; i < rounds; i++) {
+		sbi_mpsc_fifo_enqueue(&test_fifo, &e);
+		sbi_mpsc_fifo_dequeue(&test_fifo, &e);
+	}
+}
+
+SBIUNIT_BENCH(mpsc_fifo_bench, mpsc_fifo_bench_init, mpsc_fifo_bench_run);
+#endif
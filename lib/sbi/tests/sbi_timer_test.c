@@ -0,0 +1,88 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_timer.h>
+#include <sbi/sbi_unit_test.h>
+
+#define TEST_EVENTS	3
+
+static long test_order[TEST_EVENTS];
+static int test_fired;
+
+static void test_event_cb(struct sbi_timer_event *ev)
+{
+	if (test_fired < TEST_EVENTS)
+		test_order[test_fired] = (long)ev->priv;
+	test_fired++;
+}
+
+static void timer_event_order_test(struct sbiunit_test_case *test)
+{
+	struct sbi_timer_event ev[TEST_EVENTS];
+	u64 now = sbi_timer_value();
+	long i;
+
+	for (i = 0; i < TEST_EVENTS; i++)
+		sbi_timer_event_init(&ev[i], test_event_cb, (void *)i);
+	test_fired = 0;
+
+	if (sbi_timer_add_event(&ev[0], now + 3) == SBI_ENODEV) {
+		SBIUNIT_INFO(test, "no timer compare, skipping\n");
+		return;
+	}
+	SBIUNIT_EXPECT_EQ(test, sbi_timer_add_event(&ev[1], now + 1), 0);
+	SBIUNIT_EXPECT_EQ(test, sbi_timer_add_event(&ev[2], now + 2), 0);
+	SBIUNIT_EXPECT(test, sbi_timer_event_pending(&ev[2]));
+
+	sbi_timer_del_event(&ev[2]);
+	SBIUNIT_EXPECT(test, !sbi_timer_event_pending(&ev[2]));
+
+	/* Interrupts are disabled in M-mode so process expired events here */
+	while (sbi_timer_value() <= now + 3)
+		;
+	sbi_timer_process();
+
+	SBIUNIT_EXPECT_EQ(test, test_fired, 2);
+	SBIUNIT_EXPECT_EQ(test, test_order[0], 1);
+	SBIUNIT_EXPECT_EQ(test, test_order[1], 0);
+	for (i = 0; i < TEST_EVENTS; i++)
+		SBIUNIT_EXPECT(test, !sbi_timer_event_pending(&ev[i]));
+
+	/* The events live on the stack, never leave them queued */
+	for (i = 0; i < TEST_EVENTS; i++)
+		sbi_timer_del_event(&ev[i]);
+}
+
+static void timer_event_rearm_test(struct sbiunit_test_case *test)
+{
+	struct sbi_timer_event ev;
+	u64 now = sbi_timer_value();
+
+	sbi_timer_event_init(&ev, test_event_cb, NULL);
+	test_fired = 0;
+
+	if (sbi_timer_add_event(&ev, now + 1) == SBI_ENODEV) {
+		SBIUNIT_INFO(test, "no timer compare, skipping\n");
+		return;
+	}
+
+	/* Moving a pending event must not leave it queued twice */
+	SBIUNIT_EXPECT_EQ(test, sbi_timer_add_event(&ev, -1ULL - 1), 0);
+	while (sbi_timer_value() <= now + 1)
+		;
+	sbi_timer_process();
+	SBIUNIT_EXPECT_EQ(test, test_fired, 0);
+	SBIUNIT_EXPECT(test, sbi_timer_event_pending(&ev));
+
+	sbi_timer_del_event(&ev);
+	SBIUNIT_EXPECT(test, !sbi_timer_event_pending(&ev));
+}
+
+static struct sbiunit_test_case timer_test_cases[] = {
+	SBIUNIT_TEST_CASE(timer_event_order_test),
+	SBIUNIT_TEST_CASE(timer_event_rearm_test),
+	SBIUNIT_END_CASE,
+};
+
+SBIUNIT_TEST_SUITE(timer_test_suite, timer_test_cases);
@@ -3,6 +3,7 @@
  *
  * Author: Ivan Orlov <ivan.orlov0322@gmail.com>
  */
+#include <sbi/riscv_asm.h>
 #include <sbi/sbi_unit_test.h>
 #include <sbi/sbi_types.h>
 #include <sbi/sbi_console.h>
@@ -41,6 +42,40 @@ static void run_test_suite(struct sbiunit_test_suite *suite)
 		   count_pass + count_fail);
 }
 
+#ifdef CONFIG_SBIUNIT_BENCH
+extern struct sbiunit_bench *const sbi_unit_benches[];
+
+static void run_bench(struct sbiunit_bench *bench)
+{
+	unsigned long t0, cycles;
+
+	if (bench->init)
+		bench->init();
+
+	/* Warm up caches and branch predictors first */
+	bench->run(SBIUNIT_BENCH_ROUNDS / 16);
+
+	t0 = csr_read(CSR_MCYCLE);
+	bench->run(SBIUNIT_BENCH_ROUNDS);
+	cycles = csr_read(CSR_MCYCLE) - t0;
+
+	sbi_printf("%s: %lu cycles/op\n", bench->name,
+		   cycles / SBIUNIT_BENCH_ROUNDS);
+}
+
+static void run_all_benches(void)
+{
+	u32 i;
+
+	sbi_printf("\n# Running SBIUNIT benchmarks #\n");
+
+	for (i = 0; sbi_unit_benches[i]; i++)
+		run_bench(sbi_unit_benches[i]);
+}
+#else
+static inline void run_all_benches(void) { }
+#endif
+
 void run_all_tests(void)
 {
 	u32 i;
@@ -49,4 +84,6 @@ void run_all_tests(void)
 
 	for (i = 0; sbi_unit_tests[i]; i++)
 		run_test_suite(sbi_unit_tests[i]);
+
+	run_all_benches();
 }
@@ -45,6 +45,31 @@ static void mswi_ipi_send(u32 hart_index)
 			mswi->first_hartid]);
 }
 
+static void mswi_ipi_send_many(const struct sbi_hartmask *mask)
+{
+	u32 i, *msip = NULL;
+	struct sbi_scratch *scratch;
+	struct aclint_mswi_data *mswi, *prev = NULL;
+
+	/* Back-to-back relaxed writes, the caller already did wmb() */
+	sbi_hartmask_for_each_hartindex(i, mask) {
+		scratch = sbi_hartindex_to_scratch(i);
+		if (!scratch)
+			continue;
+
+		mswi = mswi_get_hart_data_ptr(scratch);
+		if (!mswi)
+			continue;
+		if (mswi != prev) {
+			msip = (void *)mswi->addr;
+			prev = mswi;
+		}
+
+		writel_relaxed(1, &msip[sbi_hartindex_to_hartid(i) -
+				mswi->first_hartid]);
+	}
+}
+
 static void mswi_ipi_clear(void)
 {
 	u32 *msip;
@@ -63,6 +88,7 @@ static void mswi_ipi_clear(void)
 static struct sbi_ipi_device aclint_mswi = {
 	.name = "aclint-mswi",
 	.ipi_send = mswi_ipi_send,
+	.ipi_send_many = mswi_ipi_send_many,
 	.ipi_clear = mswi_ipi_clear
 };
 
@@ -197,9 +197,19 @@ static void imsic_ipi_send(u32 hart_index)
 			(void *)(regs->addr + reloff + IMSIC_MMIO_PAGE_LE));
 }
 
+static void imsic_ipi_send_many(const struct sbi_hartmask *mask)
+{
+	u32 i;
+
+	/* Each send is a relaxed write, the caller already did wmb() */
+	sbi_hartmask_for_each_hartindex(i, mask)
+		imsic_ipi_send(i);
+}
+
 static struct sbi_ipi_device imsic_ipi_device = {
 	.name		= "aia-imsic",
-	.ipi_send	= imsic_ipi_send
+	.ipi_send	= imsic_ipi_send,
+	.ipi_send_many	= imsic_ipi_send_many
 };
 
 static void imsic_local_eix_update(unsigned long base_id,
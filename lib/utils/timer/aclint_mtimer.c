@@ -85,6 +85,27 @@ static void mtimer_event_stop(void)
 	mt->time_wr(true, -1ULL, &time_cmp[target_hart - mt->first_hartid]);
 }
 
+static void *mtimer_event_fast_cmp(void)
+{
+#if __riscv_xlen != 32
+	u32 target_hart = current_hartid();
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct aclint_mtimer_data *mt;
+	u64 *time_cmp;
+
+	mt = mtimer_get_hart_data_ptr(scratch);
+
+	/* Only a single 64-bit store is done by the fast path */
+	if (!mt || mt->time_wr != mtimer_time_wr64)
+		return NULL;
+
+	time_cmp = (void *)mt->mtimecmp_addr;
+	return &time_cmp[target_hart - mt->first_hartid];
+#else
+	return NULL;
+#endif
+}
+
 static void mtimer_event_start(u64 next_event)
 {
 	u32 target_hart = current_hartid();
@@ -106,7 +127,8 @@ static struct sbi_timer_device mtimer = {
 	.name = "aclint-mtimer",
 	.timer_value = mtimer_value,
 	.timer_event_start = mtimer_event_start,
-	.timer_event_stop = mtimer_event_stop
+	.timer_event_stop = mtimer_event_stop,
+	.timer_event_fast_cmp = mtimer_event_fast_cmp
 };
 
 void aclint_mtimer_sync(struct aclint_mtimer_data *mt)
@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Copyright (c) 2026 Sophgo Technology Inc.
+#
+# Symbolize the samples printed by the OpenSBI M-mode profiler
+# (CONFIG_SBI_PROFILER) against the firmware ELF.
+#
+# Usage: sbi-profile.py [-n NM] [-d DEPTH] fw_xyz.elf console.log
+
+import argparse
+import bisect
+import collections
+import re
+import subprocess
+import sys
+
+
+def load_symbols(nm, elf):
+    out = subprocess.run([nm, "-n", "--defined-only", elf],
+                         capture_output=True, text=True, check=True).stdout
+    addrs, names, fw_start = [], [], None
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) != 3 or parts[1] not in "tTwW":
+            if len(parts) == 3 and parts[2] == "_fw_start":
+                fw_start = int(parts[0], 16)
+            continue
+        addr = int(parts[0], 16)
+        if parts[2] == "_fw_start":
+            fw_start = addr
+        addrs.append(addr)
+        names.append(parts[2])
+    return addrs, names, fw_start
+
+
+def symbolize(addrs, names, addr):
+    i = bisect.bisect_right(addrs, addr) - 1
+    if i < 0:
+        return "0x%x" % addr
+    return "%s+0x%x" % (names[i], addr - addrs[i])
+
+
+def function(addrs, names, addr):
+    i = bisect.bisect_right(addrs, addr) - 1
+    return names[i] if i >= 0 else "0x%x" % addr
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("-n", "--nm", default="riscv64-unknown-elf-nm",
+                        help="nm tool understanding the firmware ELF")
+    parser.add_argument("-d", "--depth", type=int, default=4,
+                        help="number of call chain entries to show")
+    parser.add_argument("-t", "--top", type=int, default=20,
+                        help="number of hottest call chains to show")
+    parser.add_argument("elf", help="firmware ELF (e.g. fw_dynamic.elf)")
+    parser.add_argument("log", help="console log containing PROF lines")
+    args = parser.parse_args()
+
+    addrs, names, elf_start = load_symbols(args.nm, args.elf)
+    offset = 0
+    funcs = collections.Counter()
+    chains = collections.Counter()
+    total = 0
+
+    with open(args.log, errors="replace") as f:
+        for line in f:
+            m = re.search(r"PROF (.*)$", line)
+            if not m:
+                continue
+            fields = m.group(1).split()
+            if fields[0] == "base":
+                if elf_start is not None:
+                    offset = int(fields[1], 16) - elf_start
+                continue
+            if fields[0] == "end":
+                continue
+            pcs = [int(x, 16) - offset for x in fields[2:]]
+            if not pcs:
+                continue
+            total += 1
+            funcs[function(addrs, names, pcs[0])] += 1
+            chains[" <- ".join(symbolize(addrs, names, pc)
+                               for pc in pcs[:args.depth])] += 1
+
+    if not total:
+        sys.exit("no profiler samples found in %s" % args.log)
+
+    print("%d samples\n" % total)
+    print("Functions:")
+    for name, count in funcs.most_common(args.top):
+        print("%6.2f%% %6d  %s" % (100.0 * count / total, count, name))
+    print("\nCall chains:")
+    for chain, count in chains.most_common(args.top):
+        print("%6.2f%% %6d  %s" % (100.0 * count / total, count, chain))
+
+
+if __name__ == "__main__":
+    main()